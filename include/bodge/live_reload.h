@@ -0,0 +1,244 @@
+#pragma once
+
+#ifndef BODGE_LIVE_RELOAD_H
+#define BODGE_LIVE_RELOAD_H
+
+/**
+ * @file live_reload.h
+ * @brief Header-only client that reloads a shared library whenever a bodge daemon rebuilds it
+ *
+ * The library exports a function that returns a table of function pointers:
+ *
+ *     struct PluginApi { void (*update)(float dt); };
+ *     extern "C" const PluginApi* plugin_api() { static const PluginApi api{&update}; return &api; }
+ *
+ * The host loads it through LiveReload and calls poll() regularly, e.g. once per frame:
+ *
+ *     bodge::LiveReload<PluginApi> plugin("plugin", "./libplugin.so", "plugin_api");
+ *     while (running) {
+ *         plugin.poll();
+ *         plugin->update(dt);
+ *     }
+ *
+ * poll() never blocks. When the daemon has rebuilt the library, poll() loads the new version,
+ * switches to its function table and unloads the previous version, so the host must not keep
+ * pointers to functions or data of the library across calls to poll(); state that has to
+ * survive a reload belongs to the host. If no daemon runs, poll() tries to connect again once
+ * per second. On Windows the library is loaded once and never reloaded. Hosts built with
+ * glibc before 2.34 link with -ldl.
+ */
+
+#include <chrono>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace bodge {
+
+template <typename Api>
+class LiveReload {
+public:
+    /**
+     * @brief Loads the library and subscribes to its new versions
+     * @param target Name of the shared library target in the .bodge file
+     * @param path Path of the library built by bodge
+     * @param symbol Exported function that returns the function table
+     * @param project_dir Directory the daemon runs in
+     * @param platform Platform of the library, empty for the first platform the daemon builds
+     */
+    LiveReload(std::string target, const std::string& path, std::string symbol, std::string project_dir = ".",
+               std::string platform = "")
+        : target_(std::move(target)), symbol_(std::move(symbol)), project_dir_(std::move(project_dir)),
+          platform_(std::move(platform)) {
+        load(path);
+    }
+
+    ~LiveReload() {
+        disconnect();
+        close_library(handle_);
+    }
+
+    LiveReload(const LiveReload&) = delete;
+    LiveReload& operator=(const LiveReload&) = delete;
+
+    const Api* operator->() const { return api_; }
+    const Api* get() const { return api_; }
+
+    /**
+     * @brief Checks if a version of the library is loaded
+     */
+    bool is_loaded() const { return api_ != nullptr; }
+
+    /**
+     * @brief Number of versions loaded so far, 1 after the initial load
+     */
+    unsigned version() const { return version_; }
+
+    /**
+     * @brief Reason the last load or subscription failed
+     */
+    const std::string& error() const { return error_; }
+
+    /**
+     * @brief Loads the newest version of the library if the daemon sent one
+     * @return true if a new version was loaded
+     */
+    bool poll() {
+#ifdef _WIN32
+        return false;
+#else
+        if (fd_ < 0) {
+            connect_to_daemon();
+            if (fd_ < 0) {
+                return false;
+            }
+        }
+
+        char buffer[4096];
+        while (true) {
+            ssize_t count = read(fd_, buffer, sizeof(buffer));
+            if (count > 0) {
+                received_.append(buffer, static_cast<size_t>(count));
+            } else if (count < 0 && errno == EINTR) {
+                continue;
+            } else {
+                // End of file: the daemon stopped or rejected the subscription
+                if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    disconnect();
+                }
+                break;
+            }
+        }
+
+        // Only the newest of several versions sent since the last poll is loaded
+        std::string newest;
+        size_t end;
+        while ((end = received_.find('\n')) != std::string::npos) {
+            std::string line = received_.substr(0, end);
+            received_.erase(0, end + 1);
+            size_t tab = line.find('\t', 7);
+            if (line.compare(0, 7, "reload\t") == 0 && tab != std::string::npos) {
+                newest = line.substr(tab + 1);
+            } else if (line.compare(0, 6, "error\t") == 0) {
+                error_ = line.substr(6);
+            }
+        }
+        return !newest.empty() && load(newest);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    using Handle = HMODULE;
+#else
+    using Handle = void*;
+#endif
+
+    std::string target_;
+    std::string symbol_;
+    std::string project_dir_;
+    std::string platform_;
+    Handle handle_ = nullptr;
+    const Api* api_ = nullptr;
+    unsigned version_ = 0;
+    std::string error_;
+    int fd_ = -1;
+    std::string received_;
+    bool attempted_ = false;
+    std::chrono::steady_clock::time_point last_attempt_;
+
+    bool load(const std::string& path) {
+#ifdef _WIN32
+        Handle handle = LoadLibraryA(path.c_str());
+        void* entry = handle != nullptr ? reinterpret_cast<void*>(GetProcAddress(handle, symbol_.c_str())) : nullptr;
+#else
+        Handle handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        void* entry = handle != nullptr ? dlsym(handle, symbol_.c_str()) : nullptr;
+#endif
+        const Api* api = entry != nullptr ? reinterpret_cast<const Api* (*)()>(entry)() : nullptr;
+        if (api == nullptr) {
+            error_ = handle == nullptr ? "cannot load " + path : "no function table returned by " + symbol_ + " in " + path;
+            close_library(handle);
+            return false;
+        }
+
+        close_library(handle_);
+        handle_ = handle;
+        api_ = api;
+        ++version_;
+        return true;
+    }
+
+    static void close_library(Handle handle) {
+        if (handle != nullptr) {
+#ifdef _WIN32
+            FreeLibrary(handle);
+#else
+            dlclose(handle);
+#endif
+        }
+    }
+
+#ifndef _WIN32
+    void connect_to_daemon() {
+        auto now = std::chrono::steady_clock::now();
+        if (attempted_ && now - last_attempt_ < std::chrono::seconds(1)) {
+            return;
+        }
+        attempted_ = true;
+        last_attempt_ = now;
+
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::string socket_path = project_dir_ + "/.bodge_cache/daemon.sock";
+        if (socket_path.size() >= sizeof(address.sun_path)) {
+            error_ = "path of the daemon socket is too long: " + socket_path;
+            return;
+        }
+        std::strcpy(address.sun_path, socket_path.c_str());
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        std::string request = "reload\t" + target_ + "\t" + platform_ + "\n";
+        int flags = 0;
+#ifdef MSG_NOSIGNAL
+        flags = MSG_NOSIGNAL;
+#endif
+        // The daemon answers once it is idle, so the answer is read by later polls
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            send(fd, request.data(), request.size(), flags) != static_cast<ssize_t>(request.size())) {
+            close(fd);
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fd_ = fd;
+    }
+
+    void disconnect() {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+#else
+    void disconnect() {}
+#endif
+};
+
+} // namespace bodge
+
+#endif // BODGE_LIVE_RELOAD_H
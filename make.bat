@@ -7,7 +7,7 @@ set CXX=g++
 set CXXFLAGS=-std=c++17 -Wall -Wextra -Wpedantic -O2 -static-libgcc -static-libstdc++
 set TARGET=bodge.exe
 set SRCDIR=src
-set SOURCES=%SRCDIR%\core.cpp %SRCDIR%\main.cpp %SRCDIR%\ProjectConfig.cpp %SRCDIR%\StringUtils.cpp %SRCDIR%\ConfigParser.cpp %SRCDIR%\BuildSystem.cpp %SRCDIR%\git.cpp %SRCDIR%\FileSystemUtils.cpp %SRCDIR%\Architecture.cpp %SRCDIR%\FileWatcher.cpp %SRCDIR%\BuildLogger.cpp %SRCDIR%\ProgressBar.cpp %SRCDIR%\Strings.cpp
+set SOURCES=%SRCDIR%\core.cpp %SRCDIR%\main.cpp %SRCDIR%\ProjectConfig.cpp %SRCDIR%\StringUtils.cpp %SRCDIR%\ConfigParser.cpp %SRCDIR%\BuildSystem.cpp %SRCDIR%\git.cpp %SRCDIR%\FileSystemUtils.cpp %SRCDIR%\Architecture.cpp %SRCDIR%\FileWatcher.cpp %SRCDIR%\BuildLogger.cpp %SRCDIR%\ProgressBar.cpp %SRCDIR%\Strings.cpp %SRCDIR%\IncludeGraph.cpp %SRCDIR%\PathTable.cpp %SRCDIR%\DependencyGraph.cpp %SRCDIR%\ConfigSnapshot.cpp %SRCDIR%\BuildPlan.cpp %SRCDIR%\BuildScheduler.cpp %SRCDIR%\NinjaGenerator.cpp %SRCDIR%\RuleStamps.cpp %SRCDIR%\ContentHash.cpp %SRCDIR%\ProcessRunner.cpp %SRCDIR%\BuildLock.cpp %SRCDIR%\DaemonSocket.cpp %SRCDIR%\DaemonMetrics.cpp %SRCDIR%\MetricsServer.cpp %SRCDIR%\JobPriority.cpp %SRCDIR%\LibraryReloader.cpp %SRCDIR%\TestRunner.cpp
 
 REM Check if first argument is provided, default to "all"
 if "%1"=="" (
@@ -117,10 +117,12 @@ struct PlatformConfig {
     Platform target_platform;
     std::vector<std::string> cxx_flags;
     std::vector<std::string> sources;
+    std::vector<std::string> source_patterns;  // Raw patterns as written in .bodge
     std::vector<std::string> include_dirs;
     std::vector<std::string> library_dirs;
     std::vector<std::string> libraries;
     std::string output_name_suffix;  // e.g., "_x64", "_win32"
+    bool sources_resolved = false;   // Set once source_patterns have been expanded into sources
     
     PlatformConfig() = default;
     PlatformConfig(const Platform& platform) : target_platform(platform) {}
@@ -0,0 +1,70 @@
+#include "BuildLock.h"
+#include "core.h"
+#include <filesystem>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+BuildLock::BuildLock(const std::string& project_dir)
+    : cache_dir_(project_dir + "/" BODGE_CACHE_DIR), path_(cache_dir_ + "/build.lock") {
+}
+
+BuildLock::~BuildLock() {
+    release();
+}
+
+bool BuildLock::try_acquire() {
+    return open() && lock(false);
+}
+
+bool BuildLock::acquire() {
+    return open() && lock(true);
+}
+
+void BuildLock::release() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        // Closing the descriptor releases the lock
+        close(fd_);
+    }
+#endif
+    fd_ = -1;
+    locked_ = false;
+}
+
+bool BuildLock::open() {
+#ifdef _WIN32
+    return true;
+#else
+    if (fd_ >= 0) {
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(cache_dir_, ec);
+
+    // Not inherited by compiler processes, which would otherwise keep the lock after a crash
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    return fd_ >= 0;
+#endif
+}
+
+bool BuildLock::lock(bool wait) {
+#ifdef _WIN32
+    (void)wait;
+    locked_ = true;
+    return true;
+#else
+    if (locked_) {
+        return true;
+    }
+    int result;
+    while ((result = flock(fd_, LOCK_EX | (wait ? 0 : LOCK_NB))) < 0 && errno == EINTR) {
+    }
+    locked_ = result == 0;
+    return locked_;
+#endif
+}
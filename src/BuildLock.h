@@ -0,0 +1,66 @@
+#pragma once
+
+#ifndef BUILD_LOCK_H
+#define BUILD_LOCK_H
+
+#include <string>
+
+/**
+ * @brief Exclusive lock that keeps two bodge processes from building the same tree at once
+ *
+ * The lock is an flock() on a file in the cache directory. The operating system releases
+ * it when the process exits, so a crashed build never leaves a stale lock behind. On
+ * Windows locking is not supported and acquiring always succeeds.
+ */
+class BuildLock {
+public:
+    /**
+     * @brief Constructor
+     * @param project_dir Directory of the project whose tree is locked
+     */
+    explicit BuildLock(const std::string& project_dir = ".");
+    ~BuildLock();
+    BuildLock(const BuildLock&) = delete;
+    BuildLock& operator=(const BuildLock&) = delete;
+
+    /**
+     * @brief Takes the lock if no other process holds it
+     * @return true if the lock is held now
+     */
+    bool try_acquire();
+
+    /**
+     * @brief Takes the lock, waiting for the process holding it to finish
+     * @return true if the lock is held now, false if the lock file cannot be opened
+     */
+    bool acquire();
+
+    /**
+     * @brief Releases the lock
+     */
+    void release();
+
+    /**
+     * @brief Gets the path of the lock file
+     */
+    const std::string& get_path() const { return path_; }
+
+private:
+    /**
+     * @brief Opens (and creates) the lock file
+     */
+    bool open();
+
+    /**
+     * @brief Locks the opened file
+     * @param wait true to wait until the lock is available
+     */
+    bool lock(bool wait);
+
+    std::string cache_dir_;
+    std::string path_;
+    int fd_ = -1;
+    bool locked_ = false;
+};
+
+#endif // BUILD_LOCK_H
@@ -90,6 +90,10 @@ void BuildLogger::log_changed_files(const std::vector<std::string>& changed_file
     }
 }
 
+void BuildLogger::log_test(const std::string& test_name, const std::string& message) {
+    write_log_line("[TEST " + test_name + "] " + message);
+}
+
 bool BuildLogger::is_open() const {
     return log_file_.is_open();
 }
@@ -114,6 +118,7 @@ std::string BuildLogger::get_timestamp() const {
 }
 
 void BuildLogger::write_log_line(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (log_file_.is_open()) {
         log_file_ << "[" << get_timestamp() << "] " << message << std::endl;
         log_file_.flush(); // Ensure immediate write
@@ -7,10 +7,13 @@
 #include <vector>
 #include <fstream>
 #include <chrono>
+#include <mutex>
 #include "core.h"
 
 /**
  * @brief Class for logging build operations to a file
+ *
+ * Lines may be written from several threads, e.g. by tests running next to a build.
  */
 class BuildLogger {
 public:
@@ -67,6 +70,13 @@ public:
      */
     void log_changed_files(const std::vector<std::string>& changed_files);
 
+    /**
+     * @brief Logs a line of output or the result of a test
+     * @param test_name Name of the test
+     * @param message Line to log
+     */
+    void log_test(const std::string& test_name, const std::string& message);
+
     /**
      * @brief Checks if the logger is open and ready
      * @return true if logger is ready to write
@@ -76,6 +86,7 @@ public:
 private:
     std::string log_file_path_;
     std::ofstream log_file_;
+    std::mutex mutex_;
     int build_count_;
     int success_count_;
     int failure_count_;
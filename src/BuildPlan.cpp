@@ -0,0 +1,380 @@
+#include "BuildPlan.h"
+#include "DependencyGraph.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+namespace {
+    // Helper function to validate that a string doesn't contain command injection attempts
+    bool is_safe_compiler_argument(const std::string& arg) {
+        // Check for dangerous patterns
+        const std::vector<std::string> dangerous_patterns = {
+            ";", "&&", "||", "|", "`", "$(", "${", "\n", "\r"
+        };
+
+        for (const auto& pattern : dangerous_patterns) {
+            if (arg.find(pattern) != std::string::npos) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void append(std::vector<std::string>& to, const std::vector<std::string>& from) {
+        to.insert(to.end(), from.begin(), from.end());
+    }
+
+    void append_prefixed(std::vector<std::string>& to, const std::vector<std::string>& from, const std::string& prefix) {
+        for (const std::string& item : from) {
+            to.push_back(prefix + item);
+        }
+    }
+
+    // Namespaced references such as "libs/core:core" link against the target's output
+    void append_libraries(std::vector<std::string>& to, const ProjectConfig& config, const std::vector<std::string>& libraries) {
+        for (const std::string& library : libraries) {
+            auto it = library.find(':') != std::string::npos ? config.targets.find(library) : config.targets.end();
+            to.push_back("-l" + (it != config.targets.end() ? it->second.output_name : library));
+        }
+    }
+}
+
+BuildPlan::BuildPlan(const ProjectConfig& config, const std::vector<Platform>& platforms) {
+    // Generator rules run once for all platforms, before any target that uses them
+    std::vector<const GeneratorRule*> rules;
+    std::map<std::string, uint32_t> rule_index;
+    for (const auto& [name, rule] : config.rules) {
+        if (rule.inputs_resolved) {
+            rule_index[name] = static_cast<uint32_t>(rules.size());
+            rules.push_back(&rule);
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> rule_edges;
+    for (uint32_t i = 0; i < rules.size(); ++i) {
+        for (const std::string& dependency : config.get_rule_dependencies(*rules[i])) {
+            auto it = rule_index.find(dependency);
+            if (it != rule_index.end()) {
+                rule_edges.emplace_back(it->second, i);
+            }
+        }
+    }
+
+    DependencyGraph rule_graph(rules.size(), rule_edges);
+    std::vector<uint32_t> rule_order;
+    if (!rule_graph.topological_order(rule_order)) {
+        std::cerr << "[WARNING] Circular dependency between generator rules detected. Using alphabetical order." << std::endl;
+        rule_order.clear();
+        for (uint32_t i = 0; i < rules.size(); ++i) {
+            rule_order.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> rule_position(rules.size());
+    for (uint32_t i = 0; i < rule_order.size(); ++i) {
+        rule_position[rule_order[i]] = i;
+    }
+
+    DependencyGraph rule_dependencies = rule_graph.reversed();
+    for (uint32_t node : rule_order) {
+        BuildAction action = plan_rule(*rules[node]);
+        for (uint32_t dependency : rule_dependencies.successors(node)) {
+            action.deps.push_back(rule_position[dependency]);
+        }
+        actions_.push_back(std::move(action));
+    }
+
+    for (const Platform& platform : platforms) {
+        if (std::find(platforms_.begin(), platforms_.end(), platform) != platforms_.end()) {
+            continue;
+        }
+        platforms_.push_back(platform);
+
+        // Collect the targets planned for this platform, in name order
+        std::vector<const BuildTarget*> targets;
+        std::map<std::string, uint32_t> index;
+        for (const auto& [name, target] : config.targets) {
+            if (target.sources_resolved && target.should_build_for_platform(platform)) {
+                index[name] = static_cast<uint32_t>(targets.size());
+                targets.push_back(&target);
+            }
+        }
+
+        // Libraries come before the targets that link against them
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        for (uint32_t i = 0; i < targets.size(); ++i) {
+            for (const std::string& dependency : config.get_target_dependencies(*targets[i])) {
+                auto it = index.find(dependency);
+                if (it != index.end()) {
+                    edges.emplace_back(it->second, i);
+                }
+            }
+        }
+
+        DependencyGraph graph(targets.size(), edges);
+        std::vector<uint32_t> order;
+        if (!graph.topological_order(order)) {
+            std::cerr << "[WARNING] Circular dependency between targets detected. Using alphabetical order." << std::endl;
+            order.clear();
+            for (uint32_t i = 0; i < targets.size(); ++i) {
+                order.push_back(i);
+            }
+        }
+
+        uint32_t first = static_cast<uint32_t>(actions_.size());
+        std::vector<uint32_t> position(targets.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            position[order[i]] = first + i;
+        }
+
+        DependencyGraph dependencies = graph.reversed();
+        for (uint32_t node : order) {
+            BuildAction action = plan_action(config, *targets[node], platform);
+            for (const std::string& rule : config.get_target_rules(*targets[node])) {
+                auto it = rule_index.find(rule);
+                if (it != rule_index.end()) {
+                    action.deps.push_back(rule_position[it->second]);
+                }
+            }
+            for (uint32_t dependency : dependencies.successors(node)) {
+                action.deps.push_back(position[dependency]);
+            }
+            actions_.push_back(std::move(action));
+        }
+    }
+}
+
+const BuildAction* BuildPlan::find(const std::string& target_name, const Platform& platform) const {
+    for (const BuildAction& action : actions_) {
+        if (action.platform == platform && action.target == target_name) {
+            return &action;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<uint32_t> BuildPlan::with_rules(const std::vector<uint32_t>& selected) const {
+    std::vector<bool> included(actions_.size(), false);
+    std::vector<uint32_t> pending = selected;
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+        if (included[index]) {
+            continue;
+        }
+        included[index] = true;
+        for (uint32_t dependency : actions_[index].deps) {
+            if (actions_[dependency].kind == ActionKind::RULE) {
+                pending.push_back(dependency);
+            }
+        }
+    }
+
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < actions_.size(); ++i) {
+        if (included[i]) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+std::vector<uint32_t> BuildPlan::with_dependents(const std::vector<uint32_t>& selected) const {
+    std::vector<std::vector<uint32_t>> dependents(actions_.size());
+    for (uint32_t i = 0; i < actions_.size(); ++i) {
+        for (uint32_t dependency : actions_[i].deps) {
+            dependents[dependency].push_back(i);
+        }
+    }
+
+    std::vector<bool> included(actions_.size(), false);
+    std::vector<uint32_t> pending = selected;
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+        if (included[index]) {
+            continue;
+        }
+        included[index] = true;
+        pending.insert(pending.end(), dependents[index].begin(), dependents[index].end());
+    }
+
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < actions_.size(); ++i) {
+        if (included[i]) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+BuildAction BuildPlan::plan_rule(const GeneratorRule& rule) {
+    BuildAction action;
+    action.kind = ActionKind::RULE;
+    action.target = rule.name;
+    action.inputs = rule.inputs;
+    action.outputs = rule.outputs;
+    action.depfile = rule.depfile;
+
+    if (rule.command.empty() || rule.outputs.empty()) {
+        action.error = "Rule '" + rule.name + "' needs a 'command' and 'outputs'.";
+        return action;
+    }
+
+    // Rule commands are shell commands written by the project author, so unlike compiler
+    // arguments they are not checked for shell operators
+    auto join = [](const std::vector<std::string>& paths) {
+        std::string joined;
+        for (const std::string& path : paths) {
+            joined += (joined.empty() ? "" : " ") + path;
+        }
+        return joined;
+    };
+    std::string in = join(rule.inputs);
+    std::string out = join(rule.outputs);
+
+    const std::string& command = rule.command;
+    for (size_t i = 0; i < command.size(); ++i) {
+        if (command.compare(i, 3, "$in") == 0) {
+            action.command += in;
+            i += 2;
+        } else if (command.compare(i, 4, "$out") == 0) {
+            action.command += out;
+            i += 3;
+        } else {
+            action.command += command[i];
+        }
+    }
+
+    return action;
+}
+
+BuildAction BuildPlan::plan_action(const ProjectConfig& config, const BuildTarget& target, const Platform& platform) {
+    BuildAction action;
+    action.target = target.name;
+    action.platform = platform;
+    action.type = target.type;
+    action.compiler = config.compiler;
+
+    if (!target.is_valid()) {
+        action.error = "Target '" + target.name + "' is invalid.";
+        return action;
+    }
+
+    // Platform-specific settings: global ones by exact platform, the target's first match
+    const PlatformConfig* global_platform = nullptr;
+    auto global_plat_it = config.global_platform_configs.find(platform);
+    if (global_plat_it != config.global_platform_configs.end()) {
+        global_platform = &global_plat_it->second;
+    }
+
+    const PlatformConfig* target_platform = nullptr;
+    for (const auto& [plat, plat_config] : target.platform_configs) {
+        if (plat.matches(platform)) {
+            target_platform = &plat_config;
+            break;
+        }
+    }
+
+    // Compiler flags
+    append(action.compile_flags, config.global_cxx_flags);
+    if (global_platform != nullptr) {
+        append(action.compile_flags, global_platform->cxx_flags);
+    }
+    append(action.compile_flags, target.cxx_flags);
+    append(action.compile_flags, ArchitectureDetector::get_platform_compiler_flags(platform));
+    if (target_platform != nullptr) {
+        append(action.compile_flags, target_platform->cxx_flags);
+    }
+
+    // Build type specific flags
+    switch (target.type) {
+        case BuildType::SHARED_LIBRARY:
+            action.compile_flags.push_back("-shared");
+            if (platform.operating_system != OS::WINDOWS) {
+                action.compile_flags.push_back("-fPIC");
+            }
+            break;
+        case BuildType::STATIC_LIBRARY:
+            // Note: Static libraries need different handling (ar command)
+            // For now, we'll treat them as objects that need to be archived
+            break;
+        case BuildType::EXECUTABLE:
+            // No special flags needed
+            break;
+    }
+
+    // Include directories (-I)
+    append(action.include_dirs, config.global_include_dirs);
+    if (global_platform != nullptr) {
+        append(action.include_dirs, global_platform->include_dirs);
+    }
+    append(action.include_dirs, target.include_dirs);
+    if (target_platform != nullptr) {
+        append(action.include_dirs, target_platform->include_dirs);
+    }
+    append_prefixed(action.compile_flags, action.include_dirs, "-I");
+
+    // Source files
+    append(action.inputs, target.sources);
+    if (target_platform != nullptr) {
+        append(action.inputs, target_platform->sources);
+    }
+
+    // Output file with platform-specific suffix
+    std::string suffix = target_platform != nullptr ? target_platform->output_name_suffix : "";
+    std::string output = target.output_name + suffix + target.get_output_extension(platform);
+    action.outputs.push_back(target.base_dir.empty() ? output : target.base_dir + "/" + output);
+
+    // Library directories (-L) and libraries (-l)
+    append_prefixed(action.link_flags, config.global_library_dirs, "-L");
+    if (global_platform != nullptr) {
+        append_prefixed(action.link_flags, global_platform->library_dirs, "-L");
+    }
+    append_prefixed(action.link_flags, target.library_dirs, "-L");
+    if (target_platform != nullptr) {
+        append_prefixed(action.link_flags, target_platform->library_dirs, "-L");
+    }
+    // Libraries built by sub-projects are found in the sub-project's directory
+    for (const std::string& dependency : config.get_target_dependencies(target)) {
+        const std::string& base_dir = config.targets.at(dependency).base_dir;
+        if (!base_dir.empty()) {
+            action.link_flags.push_back("-L" + base_dir);
+        }
+    }
+    append_prefixed(action.link_flags, config.global_libraries, "-l");
+    if (global_platform != nullptr) {
+        append_prefixed(action.link_flags, global_platform->libraries, "-l");
+    }
+    append_libraries(action.link_flags, config, target.libraries);
+    if (target_platform != nullptr) {
+        append_libraries(action.link_flags, config, target_platform->libraries);
+    }
+
+    // Complete invocation: compiler, flags, sources, output, link flags
+    action.argv.push_back(action.compiler);
+    append(action.argv, action.compile_flags);
+    append(action.argv, action.inputs);
+    action.argv.push_back("-o");
+    append(action.argv, action.outputs);
+    append(action.argv, action.link_flags);
+
+    // Every argument is validated once here instead of on each execution
+    for (const std::string& arg : action.argv) {
+        if (!is_safe_compiler_argument(arg)) {
+            std::cerr << "[ERROR] Potentially dangerous compiler argument detected: " << arg << std::endl;
+            action.error = "Invalid compiler arguments detected in target '" + target.name + "'";
+            return action;
+        }
+    }
+
+    for (const std::string& arg : action.argv) {
+        if (!action.command.empty()) {
+            action.command += ' ';
+        }
+        action.command += arg;
+    }
+
+    return action;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#ifndef BUILD_PLAN_H
+#define BUILD_PLAN_H
+
+#include "ProjectConfig.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Kinds of steps in a build plan
+ */
+enum class ActionKind {
+    TARGET,  // Compiles and links a target
+    RULE     // Runs a generator rule
+};
+
+/**
+ * @brief Fully resolved, validated build step for one (target, platform) pair or generator rule
+ *
+ * All global, platform-specific and target settings are merged into flat argument
+ * vectors when the plan is created, so executing or exporting an action never has
+ * to look at the configuration again.
+ */
+struct BuildAction {
+    ActionKind kind = ActionKind::TARGET;
+    std::string target;                      // Target name, or rule name for rules
+    Platform platform;                       // Unknown for rules, which run once for all platforms
+    BuildType type = BuildType::EXECUTABLE;
+
+    std::string compiler;
+    std::vector<std::string> compile_flags;  // Flags and -I arguments, placed before the inputs
+    std::vector<std::string> inputs;         // Source files
+    std::vector<std::string> link_flags;     // -L and -l arguments, placed after the output
+    std::vector<std::string> outputs;        // Files produced by the action
+    std::vector<std::string> include_dirs;   // Include directories in search order
+    std::string depfile;                     // Rules: file listing additional inputs after a run
+
+    std::vector<std::string> argv;           // Complete compiler invocation
+    std::string command;                     // argv joined into a single command line (rules: the shell command)
+    std::vector<uint32_t> deps;              // Indices of the rules this action uses and the actions it links against
+
+    std::string error;                       // Set if the target failed validation
+
+    /**
+     * @brief Checks if the action passed validation
+     */
+    bool is_valid() const { return error.empty(); }
+};
+
+/**
+ * @brief Immutable list of build actions, resolved once per invocation
+ *
+ * Generator rules come first, followed by the target actions grouped by platform;
+ * every action comes after the actions it depends on. Only targets whose sources and
+ * rules whose inputs have been resolved (see ConfigParser::resolve_sources) are planned.
+ */
+class BuildPlan {
+public:
+    BuildPlan() = default;
+
+    /**
+     * @brief Plans every resolved target for the given platforms
+     * @param config The project configuration
+     * @param platforms Platforms to plan for; duplicates are ignored
+     */
+    BuildPlan(const ProjectConfig& config, const std::vector<Platform>& platforms);
+
+    /**
+     * @brief Gets all planned actions
+     */
+    const std::vector<BuildAction>& actions() const { return actions_; }
+
+    /**
+     * @brief Gets the platforms the plan was created for, in order
+     */
+    const std::vector<Platform>& platforms() const { return platforms_; }
+
+    /**
+     * @brief Finds the action for a target and platform
+     * @param target_name Name of the target
+     * @param platform Platform the target is built for
+     * @return The action, or nullptr if the pair was not planned
+     */
+    const BuildAction* find(const std::string& target_name, const Platform& platform) const;
+
+    /**
+     * @brief Adds the rules a set of actions depends on
+     * @param selected Indices of actions
+     * @return The actions together with the rule actions they need, in plan order
+     */
+    std::vector<uint32_t> with_rules(const std::vector<uint32_t>& selected) const;
+
+    /**
+     * @brief Adds every action that depends on a set of actions, directly or indirectly
+     * @param selected Indices of actions
+     * @return The actions together with their dependents, in plan order
+     */
+    std::vector<uint32_t> with_dependents(const std::vector<uint32_t>& selected) const;
+
+    /**
+     * @brief Resolves a single target for a platform into an action
+     * @param config The project configuration
+     * @param target The target to resolve
+     * @param platform Platform to build for
+     * @return The action; its error is set if validation failed
+     */
+    static BuildAction plan_action(const ProjectConfig& config, const BuildTarget& target, const Platform& platform);
+
+    /**
+     * @brief Resolves a generator rule into an action
+     * @param rule The rule to resolve
+     * @return The action; its error is set if the rule is incomplete
+     */
+    static BuildAction plan_rule(const GeneratorRule& rule);
+
+private:
+    std::vector<BuildAction> actions_;
+    std::vector<Platform> platforms_;
+};
+
+#endif // BUILD_PLAN_H
@@ -0,0 +1,139 @@
+#include "BuildScheduler.h"
+#include "ProgressBar.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+BuildScheduler::BuildScheduler(int jobs, std::mutex* output_mutex)
+    : jobs_(jobs > 0 ? jobs : default_jobs()), output_mutex_(output_mutex) {}
+
+int BuildScheduler::default_jobs() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 0 ? static_cast<int>(cores) : 1;
+}
+
+bool BuildScheduler::run(const BuildPlan& plan, const std::vector<uint32_t>& selected, const Executor& execute,
+                         const std::vector<uint32_t>& ranks) const {
+    const std::vector<BuildAction>& actions = plan.actions();
+
+    // Per-action state, indexed by position in the plan
+    std::vector<bool> is_selected(actions.size(), false);
+    for (uint32_t index : selected) {
+        is_selected[index] = true;
+    }
+
+    std::vector<uint32_t> waiting_for(actions.size(), 0);
+    std::vector<std::vector<uint32_t>> dependents(actions.size());
+    for (uint32_t index : selected) {
+        for (uint32_t dependency : actions[index].deps) {
+            if (is_selected[dependency]) {
+                waiting_for[index]++;
+                dependents[dependency].push_back(index);
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready_changed;
+    std::set<std::pair<uint32_t, uint32_t>> ready;  // (rank, index), so ready actions start by rank and plan order
+    auto make_ready = [&](uint32_t index) {
+        ready.insert(std::make_pair(ranks.empty() ? 0 : ranks[index], index));
+    };
+    size_t unfinished = selected.size();
+    bool all_success = true;
+    bool cancelled = false;
+
+    for (uint32_t index : selected) {
+        if (waiting_for[index] == 0) {
+            make_ready(index);
+        }
+    }
+
+    // Marks an action as finished and releases or skips its dependents (mutex held). An action
+    // with several failed dependencies is skipped by the first of them only. Skipped actions are
+    // reported once the mutex is released, under the output mutex the running actions print with
+    std::vector<bool> done(actions.size(), false);
+    std::vector<std::string> skipped;
+    std::function<void(uint32_t, bool)> finish = [&](uint32_t index, bool success) {
+        if (done[index]) {
+            return;
+        }
+        done[index] = true;
+        unfinished--;
+        if (!success) {
+            all_success = false;
+        }
+        for (uint32_t dependent : dependents[index]) {
+            if (done[dependent]) {
+                continue;
+            }
+            if (!success) {
+                skipped.push_back("Skipping target '" + actions[dependent].target + "' - dependency '" +
+                                  actions[index].target + "' failed");
+                finish(dependent, false);
+            } else if (--waiting_for[dependent] == 0) {
+                make_ready(dependent);
+            }
+        }
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready_changed.wait(lock, [&]() { return !ready.empty() || unfinished == 0 || cancelled; });
+            if (ready.empty() || cancelled) {
+                return;
+            }
+
+            uint32_t index = ready.begin()->second;
+            ready.erase(ready.begin());
+
+            lock.unlock();
+            E_RESULT result = execute(actions[index]);
+            lock.lock();
+
+            if (result == S_CANCELLED) {
+                // Actions that are still running finish on their own; nothing new starts
+                cancelled = true;
+                all_success = false;
+            } else {
+                finish(index, result == S_OK);
+            }
+            ready_changed.notify_all();
+
+            if (!skipped.empty()) {
+                std::vector<std::string> messages;
+                messages.swap(skipped);
+                lock.unlock();
+                {
+                    std::unique_lock<std::mutex> output_lock;
+                    if (output_mutex_ != nullptr) {
+                        output_lock = std::unique_lock<std::mutex>(*output_mutex_);
+                    }
+                    for (const std::string& message : messages) {
+                        ProgressBar::display_error(message);
+                    }
+                }
+                lock.lock();
+            }
+        }
+    };
+
+    // The calling thread is one of the workers
+    size_t worker_count = std::min(static_cast<size_t>(jobs_), selected.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+    if (worker_count > 0) {
+        worker();
+    }
+    for (std::thread& thread : workers) {
+        thread.join();
+    }
+
+    return all_success;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef BUILD_SCHEDULER_H
+#define BUILD_SCHEDULER_H
+
+#include "BuildPlan.h"
+#include "core.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Runs the actions of a build plan on a pool of worker threads
+ *
+ * An action is started as soon as all actions it depends on have succeeded, so
+ * independent targets (including those of merged sub-projects) compile concurrently
+ * while sharing a single job limit. Ready actions are started in order of their rank,
+ * then in plan order. If an
+ * action fails, everything that depends on it is skipped. If an action reports
+ * S_CANCELLED, no further actions are started.
+ */
+class BuildScheduler {
+public:
+    /**
+     * @brief Callback that executes one action; called from worker threads
+     */
+    typedef std::function<E_RESULT(const BuildAction&)> Executor;
+
+    /**
+     * @brief Constructor
+     * @param jobs Maximum number of actions running at the same time (0 for the number of CPU cores)
+     * @param output_mutex Mutex serializing console output with the running actions (nullptr: none)
+     */
+    explicit BuildScheduler(int jobs = 0, std::mutex* output_mutex = nullptr);
+
+    /**
+     * @brief Runs a set of actions
+     * @param plan The plan the actions belong to
+     * @param selected Indices of the actions to run; dependencies outside this set count as done
+     * @param execute Executes a single action
+     * @param ranks Rank of every action of the plan, lower ranks start first (empty: plan order)
+     * @return true if every selected action succeeded (false if the run was cancelled)
+     */
+    bool run(const BuildPlan& plan, const std::vector<uint32_t>& selected, const Executor& execute,
+             const std::vector<uint32_t>& ranks = {}) const;
+
+    /**
+     * @brief Gets the default job limit (number of CPU cores, at least 1)
+     */
+    static int default_jobs();
+
+private:
+    int jobs_;
+    std::mutex* output_mutex_;
+};
+
+#endif // BUILD_SCHEDULER_H
@@ -1,11 +1,20 @@
 #include "BuildSystem.h"
-#include "StringUtils.h"
 #include "FileWatcher.h"
 #include "BuildLogger.h"
 #include "FileSystemUtils.h"
 #include "ProgressBar.h"
+#include "IncludeGraph.h"
+#include "BuildScheduler.h"
+#include "NinjaGenerator.h"
+#include "RuleStamps.h"
+#include "ConfigParser.h"
+#include "BuildLock.h"
+#include "DaemonSocket.h"
+#include "MetricsServer.h"
+#include "LibraryReloader.h"
+#include "TestRunner.h"
+#include "StringUtils.h"
 #include <iostream>
-#include <sstream>
 #include <cstdlib>
 #include <filesystem>
 #include <thread>
@@ -13,37 +22,27 @@
 #include <csignal>
 #include <algorithm>
 #include <regex>
+#include <set>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <cstdint>
 
 namespace {
-    // Helper function to validate that a string doesn't contain command injection attempts
-    bool is_safe_compiler_argument(const std::string& arg) {
-        // Check for dangerous patterns
-        const std::vector<std::string> dangerous_patterns = {
-            ";", "&&", "||", "|", "`", "$(", "${", "\n", "\r"
-        };
-        
-        for (const auto& pattern : dangerous_patterns) {
-            if (arg.find(pattern) != std::string::npos) {
-                return false;
-            }
-        }
-        
-        return true;
-    }
-    
-    // Validate all arguments in a vector
-    bool validate_compiler_arguments(const std::vector<std::string>& args) {
-        for (const auto& arg : args) {
-            if (!is_safe_compiler_argument(arg)) {
-                std::cerr << "[ERROR] Potentially dangerous compiler argument detected: " << arg << std::endl;
-                return false;
-            }
-        }
-        return true;
-    }
+    // Serializes console output of concurrently running build actions
+    std::mutex output_mutex;
 }
 
-BuildSystem::BuildSystem(const ProjectConfig& config) : config_(config) {}
+BuildSystem::BuildSystem(const ProjectConfig& config, const std::vector<Platform>& platforms)
+    : config_(config), jobs_(0) {
+    // Sequences and single-target builds default to the current platform
+    std::vector<Platform> planned = get_target_platforms();
+    planned.push_back(ArchitectureDetector::detect_current_platform());
+    planned.insert(planned.end(), platforms.begin(), platforms.end());
+    plan_ = BuildPlan(config_, planned);
+}
 
 E_RESULT BuildSystem::prebuild_checks() const{
     // Check for essential inputs
@@ -52,19 +51,21 @@ E_RESULT BuildSystem::prebuild_checks() const{
         return S_ERROR_INVALID_ARGUMENT;
     }
 
-    // Handle git dependencies first
-    if (build_git_dependencies() != S_OK) {
-        ProgressBar::display_error("Failed to handle git dependencies.");
-        return S_BUILD_FAILED;
-    }
-
     return S_OK;
 }
 
 
 E_RESULT BuildSystem::build() const {
     ProgressBar::display_header();
+    return build_platforms(get_target_platforms());
+}
+
+E_RESULT BuildSystem::build_for_platform(const Platform& platform) const {
+    return build_platforms({platform});
+}
 
+E_RESULT BuildSystem::build_platforms(const std::vector<Platform>& platforms, const std::vector<uint32_t>* actions,
+                                      std::vector<uint32_t>* completed, const std::vector<uint32_t>* ranks) const {
     E_RESULT prechk_result = prebuild_checks();
     if (prechk_result != S_OK) {
         return prechk_result;
@@ -72,118 +73,113 @@ E_RESULT BuildSystem::build() const {
 
     auto build_start_time = std::chrono::steady_clock::now();
 
-    // Handle git dependencies first
-    if (build_git_dependencies() != S_OK) {
-        ProgressBar::display_error("Failed to handle git dependencies.");
-        return S_BUILD_FAILED;
-    }
+    // Build every planned target for all requested platforms
+    bool all_success = true;
 
-    // If we have targets, build all of them for all target platforms
-    if (!config_.targets.empty()) {
-        bool all_success = true;
-        std::vector<Platform> target_platforms = get_target_platforms();
-        
-        // Count total targets to build
-        int total_targets = 0;
-        for (const Platform& platform : target_platforms) {
-            for (const auto& [name, target] : config_.targets) {
-                if (target.should_build_for_platform(platform)) {
-                    total_targets++;
-                }
-            }
+    std::vector<bool> allowed(plan_.actions().size(), actions == nullptr);
+    if (actions != nullptr) {
+        for (uint32_t index : *actions) {
+            allowed[index] = true;
         }
-        
-        int current_target = 0;
-        ProgressBar overall_progress(total_targets, 50);
-        
-        for (const Platform& platform : target_platforms) {
-            ProgressBar::display_info("Building for platform: " + platform.to_string());
-            
-            for (const auto& [name, target] : config_.targets) {
-                if (target.should_build_for_platform(platform)) {
-                    current_target++;
-                    std::string prefix = "Overall progress (" + std::to_string(current_target) + "/" + std::to_string(total_targets) + ")";
-                    overall_progress.display(current_target, prefix);
-                    
-                    if (build_target_for_platform(name, platform) != S_OK) {
-                        all_success = false;
-                    }
-                } else {
-                    ProgressBar::display_info("Skipping target '" + name + "' - not configured for platform " + platform.to_string());
-                }
+    }
+
+    // Select the actions of every platform, together with the generator rules they use
+    std::vector<std::vector<uint32_t>> selections;
+    int total_targets = 0;
+    for (const Platform& platform : platforms) {
+        std::vector<uint32_t> selected;
+        for (uint32_t i = 0; i < plan_.actions().size(); ++i) {
+            if (allowed[i] && plan_.actions()[i].kind == ActionKind::TARGET && plan_.actions()[i].platform == platform) {
+                selected.push_back(i);
             }
         }
-        
-        auto build_end_time = std::chrono::steady_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(build_end_time - build_start_time).count();
-        
-        ProgressBar::display_build_summary(all_success, duration);
-        return all_success ? S_OK : S_BUILD_FAILED;
+        selections.push_back(plan_.with_rules(selected));
+        total_targets += static_cast<int>(selections.back().size());
     }
-    
-    // Legacy single build
-    std::string command = generate_command();
-    E_RESULT result = execute_command(command);
-    
-    auto build_end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(build_end_time - build_start_time).count();
-    
-    ProgressBar::display_build_summary(result == S_OK, duration);
-    return result;
-}
-
-E_RESULT BuildSystem::build_git_dependencies_only() const {
-    return build_git_dependencies();
-}
 
-std::string BuildSystem::generate_command() const {
-    // Validate inputs before generating command
-    if (!is_safe_compiler_argument(config_.compiler)) {
-        ProgressBar::display_error("Invalid compiler specified");
-        return "";
-    }
-    
-    if (!validate_compiler_arguments(config_.cxx_flags) ||
-        !validate_compiler_arguments(config_.include_dirs) ||
-        !validate_compiler_arguments(config_.sources) ||
-        !validate_compiler_arguments(config_.library_dirs) ||
-        !validate_compiler_arguments(config_.libraries)) {
-        ProgressBar::display_error("Invalid compiler arguments detected");
-        return "";
+    // Platforms are built one after another, the one with the most urgent action first
+    std::vector<size_t> platform_order(platforms.size());
+    std::vector<uint32_t> best_rank(platforms.size(), 0);
+    for (size_t p = 0; p < platforms.size(); ++p) {
+        platform_order[p] = p;
+        if (ranks != nullptr) {
+            best_rank[p] = UINT32_MAX;
+            for (uint32_t index : selections[p]) {
+                best_rank[p] = std::min(best_rank[p], (*ranks)[index]);
+            }
+        }
     }
-    
-    std::stringstream command;
+    std::stable_sort(platform_order.begin(), platform_order.end(),
+                     [&](size_t a, size_t b) { return best_rank[a] < best_rank[b]; });
 
-    // 1. Compiler
-    command << config_.compiler;
+    static const std::vector<uint32_t> no_ranks;
+    int current_target = 0;
+    ProgressBar overall_progress(total_targets, 50);
+    BuildScheduler scheduler(jobs_, &output_mutex);
+    // Workers of a build requested by a client send their output to it as well
+    int output_client = DaemonSocket::get_output_client();
 
-    // 2. Standard CXX Flags
-    command << " " << StringUtils::join(config_.cxx_flags, "", " ");
+    for (size_t p : platform_order) {
+        const Platform& platform = platforms[p];
+        const std::vector<uint32_t>& selected = selections[p];
+        if (actions != nullptr && selected.empty()) {
+            continue;
+        }
+        ProgressBar::display_info("Building for platform: " + platform.to_string());
 
-    // 3. Include Directories (-I)
-    command << StringUtils::join(config_.include_dirs, " -I", " ");
+        for (const auto& [name, target] : config_.targets) {
+            if (!target.should_build_for_platform(platform)) {
+                ProgressBar::display_info("Skipping target '" + name + "' - not configured for platform " + platform.to_string());
+            }
+        }
 
-    // 4. Source Files (must come before -o and linking flags)
-    command << StringUtils::join(config_.sources, "", " ");
+        // Targets start as soon as the libraries they link against are built
+        bool platform_success = scheduler.run(plan_, selected, [&](const BuildAction& action) {
+            if (output_client >= 0) {
+                DaemonSocket::redirect_output(output_client);
+            }
+            {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                current_target++;
+                std::string prefix = "Overall progress (" + std::to_string(current_target) + "/" + std::to_string(total_targets) + ")";
+                overall_progress.display(current_target, prefix);
+            }
+            uint32_t index = static_cast<uint32_t>(&action - plan_.actions().data());
+            E_RESULT result = execute_action(action, ranks != nullptr && (*ranks)[index] > 0);
+            if (result == S_OK && completed != nullptr) {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                completed->push_back(index);
+            }
+            return result;
+        }, ranks != nullptr ? *ranks : no_ranks);
 
-    // 5. Output file (-o)
-    if (!is_safe_compiler_argument(config_.output_name)) {
-        ProgressBar::display_error("Invalid output name specified");
-        return "";
+        if (!platform_success) {
+            all_success = false;
+        }
+        if (runner_.is_cancelled()) {
+            ProgressBar::display_info("Build cancelled");
+            return S_CANCELLED;
+        }
     }
-    command << " -o " << config_.output_name;
 
-    // 6. Library Directories (-L)
-    command << StringUtils::join(config_.library_dirs, " -L", " ");
+    auto build_end_time = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(build_end_time - build_start_time).count();
+
+    ProgressBar::display_build_summary(all_success, duration);
+    return all_success ? S_OK : S_BUILD_FAILED;
+}
 
-    // 7. Libraries (-l)
-    command << StringUtils::join(config_.libraries, " -l", " ");
+void BuildSystem::set_jobs(int jobs) {
+    jobs_ = jobs;
+}
 
-    return command.str();
+E_RESULT BuildSystem::build_git_dependencies_only() const {
+    return build_git_dependencies();
 }
 
-E_RESULT BuildSystem::execute_command(const std::string& command) const {
+E_RESULT BuildSystem::execute_command(const std::string& command, bool background) const {
     // Validate command is not empty (could indicate validation failure)
+    std::unique_lock<std::mutex> lock(output_mutex);
     if (command.empty()) {
         ProgressBar::display_error("Build command is empty or invalid");
         return S_ERROR_INVALID_ARGUMENT;
@@ -197,10 +193,23 @@ E_RESULT BuildSystem::execute_command(const std::string& command) const {
     
     ProgressBar::display_info("Executing build command...");
     std::cout << command << std::endl;
+    lock.unlock();
 
-    // Execute the command using the system shell
-    int result = std::system(command.c_str());
+    // Execute the command using the system shell (other commands may run concurrently). The
+    // output of commands run for a client is captured, as the console is the daemon's
+    std::function<void(const std::string&)> output;
+    if (DaemonSocket::get_output_client() >= 0) {
+        output = [](const std::string& line) {
+            std::lock_guard<std::mutex> output_lock(output_mutex);
+            std::cout << line << '\n';
+        };
+    }
+    int result = runner_.run(command, background, output);
 
+    lock.lock();
+    if (result == ProcessRunner::CANCELLED) {
+        return S_CANCELLED;
+    }
     if (result == 0) {
         ProgressBar::display_success("Build completed successfully!");
         return S_OK;
@@ -234,31 +243,119 @@ E_RESULT BuildSystem::build_target_for_platform(const std::string& target_name,
     }
     
     const BuildTarget& target = it->second;
-    if (!target.is_valid()) {
-        ProgressBar::display_error("Target '" + target_name + "' is invalid.");
-        return S_INVALID_CONFIGURATION;
-    }
-
     if (!target.should_build_for_platform(platform)) {
         ProgressBar::display_info("Skipping target '" + target_name + "' - not configured for platform " + platform.to_string());
         return S_OK;
     }
 
-    ProgressBar::display_phase_header("Building: " + target_name + " (" + platform.to_string() + ")", "🔨");
+    const BuildAction* action = plan_.find(target_name, platform);
+    if (action == nullptr) {
+        ProgressBar::display_error("Target '" + target_name + "' is not part of the build plan for platform " + platform.to_string());
+        return S_INVALID_CONFIGURATION;
+    }
+
+    // Generator rules the target uses run first
+    uint32_t index = static_cast<uint32_t>(action - plan_.actions().data());
+    std::vector<uint32_t> selected = plan_.with_rules({index});
+    if (selected.size() == 1) {
+        return execute_action(*action);
+    }
+
+    BuildScheduler scheduler(jobs_, &output_mutex);
+    bool success = scheduler.run(plan_, selected, [&](const BuildAction& selected_action) {
+        return execute_action(selected_action);
+    });
+    return success ? S_OK : S_BUILD_FAILED;
+}
+
+E_RESULT BuildSystem::execute_action(const BuildAction& action, bool background) const {
+    if (!action.is_valid()) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_error(action.error);
+        return S_INVALID_CONFIGURATION;
+    }
+
+    if (action.kind == ActionKind::RULE) {
+        return execute_rule(action, background);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_phase_header("Building: " + action.target + " (" + action.platform.to_string() + ")", "🔨");
+    }
     
     auto build_start = std::chrono::steady_clock::now();
-    std::string command = generate_target_command_for_platform(target, platform);
-    E_RESULT result = execute_command(command);
+    E_RESULT result = execute_command(action.command, background);
     auto build_end = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(build_end - build_start).count();
+    if (metrics_ != nullptr) {
+        std::chrono::duration<double> seconds = build_end - build_start;
+        metrics_->record_action(action.target, action.platform.to_string(), result, seconds.count());
+    }
     
     if (result == S_OK) {
-        ProgressBar::display_success("Target '" + target_name + "' built in " + std::to_string(duration) + "ms");
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_success("Target '" + action.target + "' built in " + std::to_string(duration) + "ms");
     }
     
     return result;
 }
 
+E_RESULT BuildSystem::execute_rule(const BuildAction& action, bool background) const {
+    bool up_to_date = RuleStamps::is_up_to_date(action);
+    if (metrics_ != nullptr) {
+        metrics_->record_cache_lookup("rule_stamps", up_to_date);
+    }
+    if (up_to_date) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_info("Rule '" + action.target + "' is up to date");
+        return S_OK;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_phase_header("Generating: " + action.target, "⚡");
+    }
+
+    // Commands should not have to create the directories of their outputs
+    try {
+        for (const std::string& output : action.outputs) {
+            std::filesystem::path parent = std::filesystem::path(output).parent_path();
+            if (!parent.empty()) {
+                std::filesystem::create_directories(parent);
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_error("Failed to create output directory for rule '" + action.target + "': " + e.what());
+        return S_DIRECTORY_OPERATION_FAILED;
+    }
+
+    auto rule_start = std::chrono::steady_clock::now();
+    E_RESULT result = execute_command(action.command, background);
+    if (metrics_ != nullptr) {
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - rule_start;
+        metrics_->record_action(action.target, "", result, seconds.count());
+    }
+    if (result != S_OK) {
+        return result;
+    }
+
+    for (const std::string& output : action.outputs) {
+        if (!FileSystemUtils::file_exists(output)) {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            ProgressBar::display_error("Rule '" + action.target + "' did not produce " + output);
+            return S_BUILD_FAILED;
+        }
+    }
+
+    if (!RuleStamps::record(action)) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        ProgressBar::display_warning("Could not record the state of rule '" + action.target + "'; it will run again");
+    }
+    return S_OK;
+}
+
 E_RESULT BuildSystem::execute_sequence(const std::string& sequence_name) const {
     auto it = config_.sequences.find(sequence_name);
     if (it == config_.sequences.end()) {
@@ -288,85 +385,19 @@ E_RESULT BuildSystem::execute_sequence(const std::string& sequence_name) const {
     return S_OK;
 }
 
-std::string BuildSystem::generate_target_command(const BuildTarget& target) const {
-    // Validate inputs
-    if (!is_safe_compiler_argument(config_.compiler)) {
-        ProgressBar::display_error("Invalid compiler specified");
-        return "";
-    }
-    
-    if (!validate_compiler_arguments(config_.global_cxx_flags) ||
-        !validate_compiler_arguments(target.cxx_flags) ||
-        !validate_compiler_arguments(config_.global_include_dirs) ||
-        !validate_compiler_arguments(target.include_dirs) ||
-        !validate_compiler_arguments(target.sources) ||
-        !validate_compiler_arguments(config_.global_library_dirs) ||
-        !validate_compiler_arguments(target.library_dirs) ||
-        !validate_compiler_arguments(config_.global_libraries) ||
-        !validate_compiler_arguments(target.libraries)) {
-        ProgressBar::display_error("Invalid compiler arguments detected in target");
-        return "";
-    }
-    
-    std::stringstream command;
-    
-    // 1. Compiler
-    command << config_.compiler;
-    
-    // 2. Global CXX Flags
-    command << " " << StringUtils::join(config_.global_cxx_flags, "", " ");
-    
-    // 3. Target-specific CXX Flags
-    command << " " << StringUtils::join(target.cxx_flags, "", " ");
-    
-    // 4. Build type specific flags
-    switch (target.type) {
-        case BuildType::SHARED_LIBRARY:
-#ifdef _WIN32
-            command << " -shared";
-#else
-            command << " -shared -fPIC";
-#endif
-            break;
-        case BuildType::STATIC_LIBRARY:
-            // Note: Static libraries need different handling (ar command)
-            // For now, we'll treat them as objects that need to be archived
-            break;
-        case BuildType::EXECUTABLE:
-            // No special flags needed
-            break;
+E_RESULT BuildSystem::generate_ninja(const std::string& filename, const std::vector<std::string>& config_files,
+                                     const std::string& regenerate_command, const std::vector<Platform>& platforms) const {
+    E_RESULT prechk_result = prebuild_checks();
+    if (prechk_result != S_OK) {
+        return prechk_result;
     }
-    
-    // 5. Global Include Directories (-I)
-    command << StringUtils::join(config_.global_include_dirs, " -I", " ");
-    
-    // 6. Target-specific Include Directories (-I)
-    command << StringUtils::join(target.include_dirs, " -I", " ");
-    
-    // 7. Source Files
-    command << StringUtils::join(target.sources, "", " ");
-    
-    // 8. Output file (-o)
-    std::string output_name = target.output_name + target.get_output_extension();
-    if (!is_safe_compiler_argument(output_name)) {
-        ProgressBar::display_error("Invalid output name specified");
-        return "";
+
+    std::vector<Platform> exported = platforms.empty() ? get_target_platforms() : platforms;
+    E_RESULT result = NinjaGenerator::generate(config_, plan_, exported, config_files, regenerate_command, filename);
+    if (result == S_OK) {
+        ProgressBar::display_success("Generated " + filename);
     }
-    command << " -o " << output_name;
-    
-    // 9. Global Library Directories (-L)
-    command << StringUtils::join(config_.global_library_dirs, " -L", " ");
-    
-    // 10. Target-specific Library Directories (-L)
-    command << StringUtils::join(target.library_dirs, " -L", " ");
-    
-    // 11. Global Libraries (-l)
-    command << StringUtils::join(config_.global_libraries, " -l", " ");
-    
-    // 12. Target-specific Libraries (-l)
-    command << StringUtils::join(target.libraries, " -l", " ");
-    
-    return command.str();
+    return result;
 }
 
 E_RESULT BuildSystem::build_git_dependencies() const {
@@ -407,44 +438,10 @@ E_RESULT BuildSystem::build_git_dependencies() const {
             
             ProgressBar::display_success("Fetched " + short_url);
             
-            if (!config_.run_bodge_after_clone.empty() && config_.run_bodge_after_clone == "true") {
-                ProgressBar::display_info("Running post-clone command in " + path);
-                
-                // Save current directory
-                std::filesystem::path original_path;
-                try {
-                    original_path = std::filesystem::current_path();
-                } catch (const std::filesystem::filesystem_error& e) {
-                    ProgressBar::display_error("Failed to get current directory: " + std::string(e.what()));
-                    return S_COMMAND_EXECUTION_FAILED;
-                }
-                
-                try {
-                    // Change to the cloned repository directory
-                    std::filesystem::current_path(path);
-                    
-                    // Run bodge in the repository directory
-                    int result = std::system("bodge");
-                    
-                    // Restore original directory immediately
-                    std::filesystem::current_path(original_path);
-                    
-                    if (result != 0) {
-                        ProgressBar::display_error("Post-clone bodge command failed with exit code: " + std::to_string(result));
-                        return S_COMMAND_EXECUTION_FAILED;
-                    }
-                    
-                    ProgressBar::display_success("Post-clone bodge command completed.");
-                } catch (const std::filesystem::filesystem_error& e) {
-                    ProgressBar::display_error("Failed to change directory: " + std::string(e.what()));
-                    // Attempt to restore original directory
-                    try {
-                        std::filesystem::current_path(original_path);
-                    } catch (...) {
-                        ProgressBar::display_error("Failed to restore original directory!");
-                    }
-                    return S_COMMAND_EXECUTION_FAILED;
-                }
+            // Dependencies with their own .bodge are merged into this project's build plan
+            // by ConfigParser instead of being built by a separate bodge process
+            if (config_.run_bodge_after_clone == "true" && FileSystemUtils::file_exists(path + "/.bodge")) {
+                ProgressBar::display_info("Building " + path + " as part of this project");
             }
         } catch (const std::exception& e) {
             ProgressBar::display_error("Exception during git operation: " + std::string(e.what()));
@@ -537,128 +534,6 @@ E_RESULT BuildSystem::create_directory(const std::string& path) const {
     }
 }
 
-std::string BuildSystem::generate_target_command_for_platform(const BuildTarget& target, const Platform& platform) const {
-    // Validate compiler
-    if (!is_safe_compiler_argument(config_.compiler)) {
-        ProgressBar::display_error("Invalid compiler specified");
-        return "";
-    }
-    
-    // Get platform-specific configuration
-    PlatformConfig platform_config = target.get_platform_config(platform);
-    
-    // Validate all arguments
-    if (!validate_compiler_arguments(config_.global_cxx_flags) ||
-        !validate_compiler_arguments(platform_config.cxx_flags) ||
-        !validate_compiler_arguments(config_.global_include_dirs) ||
-        !validate_compiler_arguments(platform_config.include_dirs) ||
-        !validate_compiler_arguments(platform_config.sources) ||
-        !validate_compiler_arguments(config_.global_library_dirs) ||
-        !validate_compiler_arguments(platform_config.library_dirs) ||
-        !validate_compiler_arguments(config_.global_libraries) ||
-        !validate_compiler_arguments(platform_config.libraries)) {
-        ProgressBar::display_error("Invalid compiler arguments detected in platform-specific target");
-        return "";
-    }
-    
-    std::stringstream command;
-    
-    // 1. Compiler
-    command << config_.compiler;
-    
-    // 2. Global CXX Flags
-    command << " " << StringUtils::join(config_.global_cxx_flags, "", " ");
-    
-    // 3. Global platform-specific flags
-    auto global_plat_it = config_.global_platform_configs.find(platform);
-    if (global_plat_it != config_.global_platform_configs.end()) {
-        if (!validate_compiler_arguments(global_plat_it->second.cxx_flags)) {
-            ProgressBar::display_error("Invalid global platform-specific compiler arguments");
-            return "";
-        }
-        command << " " << StringUtils::join(global_plat_it->second.cxx_flags, "", " ");
-    }
-    
-    // 4. Target-specific CXX Flags (including platform-specific)
-    command << " " << StringUtils::join(platform_config.cxx_flags, "", " ");
-    
-    // 5. Build type specific flags
-    switch (target.type) {
-        case BuildType::SHARED_LIBRARY:
-            if (platform.operating_system == OS::WINDOWS) {
-                command << " -shared";
-            } else {
-                command << " -shared -fPIC";
-            }
-            break;
-        case BuildType::STATIC_LIBRARY:
-            // Note: Static libraries need different handling (ar command)
-            // For now, we'll treat them as objects that need to be archived
-            break;
-        case BuildType::EXECUTABLE:
-            // No special flags needed
-            break;
-    }
-    
-    // 6. Global Include Directories (-I)
-    command << StringUtils::join(config_.global_include_dirs, " -I", " ");
-    
-    // 7. Global platform-specific include directories
-    if (global_plat_it != config_.global_platform_configs.end()) {
-        if (!validate_compiler_arguments(global_plat_it->second.include_dirs)) {
-            ProgressBar::display_error("Invalid global platform-specific include directories");
-            return "";
-        }
-        command << StringUtils::join(global_plat_it->second.include_dirs, " -I", " ");
-    }
-    
-    // 8. Platform-specific Include Directories (-I)
-    command << StringUtils::join(platform_config.include_dirs, " -I", " ");
-    
-    // 9. Platform-specific Source Files
-    command << StringUtils::join(platform_config.sources, "", " ");
-    
-    // 10. Output file (-o) with platform-specific suffix
-    std::string output_name = target.output_name + platform_config.output_name_suffix + target.get_output_extension(platform);
-    if (!is_safe_compiler_argument(output_name)) {
-        ProgressBar::display_error("Invalid output name specified");
-        return "";
-    }
-    command << " -o " << output_name;
-    
-    // 11. Global Library Directories (-L)
-    command << StringUtils::join(config_.global_library_dirs, " -L", " ");
-    
-    // 12. Global platform-specific library directories
-    if (global_plat_it != config_.global_platform_configs.end()) {
-        if (!validate_compiler_arguments(global_plat_it->second.library_dirs)) {
-            ProgressBar::display_error("Invalid global platform-specific library directories");
-            return "";
-        }
-        command << StringUtils::join(global_plat_it->second.library_dirs, " -L", " ");
-    }
-    
-    // 13. Platform-specific Library Directories (-L)
-    command << StringUtils::join(platform_config.library_dirs, " -L", " ");
-    
-    // 14. Global Libraries (-l)
-    command << StringUtils::join(config_.global_libraries, " -l", " ");
-    
-    // 15. Global platform-specific libraries
-    if (global_plat_it != config_.global_platform_configs.end()) {
-        if (!validate_compiler_arguments(global_plat_it->second.libraries)) {
-            ProgressBar::display_error("Invalid global platform-specific libraries");
-            return "";
-        }
-        command << StringUtils::join(global_plat_it->second.libraries, " -l", " ");
-    }
-    
-    // 16. Platform-specific Libraries (-l)
-    command << StringUtils::join(platform_config.libraries, " -l", " ");
-    
-    return command.str();
-}
-
 std::vector<Platform> BuildSystem::get_target_platforms() const {
     std::vector<Platform> platforms;
     
@@ -682,26 +557,60 @@ static void daemon_signal_handler(int signal) {
     daemon_should_stop = true;
 }
 
-E_RESULT BuildSystem::run_daemon_mode(int poll_interval_ms, const std::string& log_file) const {
-    std::cout << "--- Bodge Daemon Mode ---" << std::endl;
-    
-    // Check configuration validity
-    if (!config_.is_valid()) {
-        std::cerr << "[ERROR] Configuration is invalid. Please check your .bodge file." << std::endl;
-        return S_ERROR_INVALID_ARGUMENT;
+std::vector<uint32_t> BuildSystem::get_affected_actions(const std::vector<std::string>& changed_files,
+                                                       PathSet& affected_sources,
+                                                       const PathSet* formatting_only) const {
+    PathSet changed(affected_sources.get_allocator());
+    std::vector<std::string> compile_changes;
+    for (const std::string& file : changed_files) {
+        changed.emplace(FileSystemUtils::normalize_path(file));
+        if (formatting_only == nullptr || formatting_only->count(file) == 0) {
+            compile_changes.push_back(file);
+        }
     }
 
-    // Initialize build logger
-    BuildLogger logger(log_file);
-    if (!logger.open()) {
-        std::cerr << "[ERROR] Failed to open log file: " << log_file << std::endl;
-        return S_FILE_OPERATION_FAILED;
+    std::vector<uint32_t> affected;
+    for (uint32_t i = 0; i < plan_.actions().size(); ++i) {
+        const BuildAction& action = plan_.actions()[i];
+        if (action.kind == ActionKind::RULE) {
+            for (const std::string& input : action.inputs) {
+                if (changed.count(FileSystemUtils::normalize_path(input)) != 0) {
+                    affected.push_back(i);
+                    break;
+                }
+            }
+            continue;
+        }
+
+        IncludeGraph include_graph(action.include_dirs);
+        std::vector<std::string> sources = include_graph.get_affected_sources(compile_changes, action.inputs);
+        if (!sources.empty()) {
+            affected.push_back(i);
+            for (const std::string& source : sources) {
+                affected_sources.emplace(source);
+            }
+        }
     }
+    IncludeGraph::save_cache();
 
-    std::cout << "[INFO] Build logs will be written to: " << log_file << std::endl;
-    logger.log_message("Daemon mode started");
+    // Libraries are linked into their dependents, which are rebuilt as well
+    return plan_.with_dependents(affected);
+}
+
+void BuildSystem::scan_includes() const {
+    for (const BuildAction& action : plan_.actions()) {
+        if (action.kind == ActionKind::RULE) {
+            continue;
+        }
+        IncludeGraph include_graph(action.include_dirs);
+        for (const std::string& input : action.inputs) {
+            include_graph.get_transitive_includes(input);
+        }
+    }
+    IncludeGraph::save_cache();
+}
 
-    // Collect all source files and directories to watch
+std::vector<std::string> BuildSystem::get_watch_paths() const {
     std::vector<std::string> watch_paths;
     
     // Add global include directories
@@ -711,26 +620,22 @@ E_RESULT BuildSystem::run_daemon_mode(int poll_interval_ms, const std::string& l
         }
     }
     
-    // Add target-specific sources and includes
-    for (const auto& [name, target] : config_.targets) {
-        // Add source files
-        for (const std::string& source : target.sources) {
+    // Add the sources and include directories of every planned action
+    for (const BuildAction& action : plan_.actions()) {
+        for (const std::string& source : action.inputs) {
             watch_paths.push_back(source);
         }
         
-        // Add include directories
-        for (const std::string& dir : target.include_dirs) {
+        for (const std::string& dir : action.include_dirs) {
             if (FileSystemUtils::directory_exists(dir)) {
                 watch_paths.push_back(dir);
             }
         }
-        
-        // Add platform-specific sources
-        for (const auto& [platform, platform_config] : target.platform_configs) {
-            for (const std::string& source : platform_config.sources) {
-                watch_paths.push_back(source);
-            }
-        }
+    }
+
+    // Add the directories source patterns were expanded from, so new files in them are found
+    for (const std::string& dir : ConfigParser::get_source_dirs()) {
+        watch_paths.push_back(dir);
     }
 
     // Add legacy sources if present
@@ -750,89 +655,731 @@ E_RESULT BuildSystem::run_daemon_mode(int poll_interval_ms, const std::string& l
         watch_paths.push_back(".");
     }
 
+    return watch_paths;
+}
+
+std::vector<uint32_t> BuildSystem::get_changed_actions(const BuildPlan& previous) const {
+    // Actions are identified by kind, platform and name across plans
+    auto key = [](const BuildAction& action) {
+        return (action.kind == ActionKind::RULE ? std::string("rule") : action.platform.to_string()) + ":" + action.target;
+    };
+    auto dependency_keys = [&](const BuildPlan& plan, const BuildAction& action) {
+        std::vector<std::string> keys;
+        for (uint32_t dependency : action.deps) {
+            keys.push_back(key(plan.actions()[dependency]));
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    };
+
+    std::map<std::string, const BuildAction*> previous_actions;
+    for (const BuildAction& action : previous.actions()) {
+        previous_actions[key(action)] = &action;
+    }
+
+    std::vector<uint32_t> changed;
+    for (uint32_t i = 0; i < plan_.actions().size(); ++i) {
+        const BuildAction& action = plan_.actions()[i];
+        auto it = previous_actions.find(key(action));
+        if (it == previous_actions.end() || it->second->command != action.command || it->second->inputs != action.inputs ||
+            it->second->outputs != action.outputs || it->second->depfile != action.depfile ||
+            it->second->error != action.error || dependency_keys(previous, *it->second) != dependency_keys(plan_, action)) {
+            changed.push_back(i);
+        }
+    }
+
+    return plan_.with_dependents(changed);
+}
+
+E_RESULT BuildSystem::run_daemon_mode(const DaemonOptions& options) const {
+    std::cout << "--- Bodge Daemon Mode ---" << std::endl;
+    
+    // Check configuration validity
+    if (!config_.is_valid()) {
+        std::cerr << "[ERROR] Configuration is invalid. Please check your .bodge file." << std::endl;
+        return S_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The daemon builds the tree for as long as it runs; builds started elsewhere are sent to it
+    BuildLock build_lock;
+    if (!build_lock.try_acquire()) {
+        std::cerr << "[ERROR] Another bodge process is building this project." << std::endl;
+        return S_FAILURE;
+    }
+    DaemonSocket control_socket;
+    if (!control_socket.listen()) {
+        std::cerr << "[WARNING] Failed to open the daemon control socket, builds started elsewhere will wait "
+                  << "for the daemon to stop." << std::endl;
+    }
+
+    // Initialize build logger
+    BuildLogger logger(options.log_file);
+    if (!logger.open()) {
+        std::cerr << "[ERROR] Failed to open log file: " << options.log_file << std::endl;
+        return S_FILE_OPERATION_FAILED;
+    }
+
+    std::cout << "[INFO] Build logs will be written to: " << options.log_file << std::endl;
+    logger.log_message("Daemon mode started");
+
+    // Tests of rebuilt targets run while the rest of the rebuild continues
+    TestRunner tests(logger, output_mutex);
+    auto check_tests = [](const ProjectConfig& config) {
+        for (const auto& [target, command] : config.daemon_tests) {
+            if (config.targets.count(target) == 0) {
+                std::cerr << "[WARNING] daemon.test names the unknown target '" << target << "'" << std::endl;
+            }
+        }
+    };
+    auto start_test = [&](const BuildSystem& system, uint32_t index) {
+        const BuildAction& action = system.plan_.actions()[index];
+        auto test = system.config_.daemon_tests.find(action.target);
+        if (test == system.config_.daemon_tests.end()) {
+            return;
+        }
+        std::string command = TestRunner::get_test_command(action, test->second);
+        if (!command.empty()) {
+            tests.start(TestRunner::get_test_name(action), command);
+        }
+    };
+    check_tests(config_);
+
+    // Metrics are served from a thread of their own, so they can be scraped during a rebuild
+    DaemonMetrics metrics;
+    MetricsServer metrics_server(metrics);
+    if (options.metrics_port > 0) {
+        if (metrics_server.start(options.metrics_host, options.metrics_port)) {
+            std::cout << "[INFO] Metrics: http://" << options.metrics_host << ":" << options.metrics_port << "/metrics"
+                      << std::endl;
+        } else {
+            std::cerr << "[WARNING] Failed to serve metrics on " << options.metrics_host << ":" << options.metrics_port
+                      << std::endl;
+        }
+    }
+
+    // Rebuilds of targets nobody is waiting for leave the machine to the developer's other work
+    JobPriority background_priority(options.background);
+    std::string priority_error;
+    if (!background_priority.setup(priority_error)) {
+        std::cerr << "[WARNING] Background jobs are not limited by a cgroup: " << priority_error << std::endl;
+    }
+
+    // Header edits are compared with the tokens found now (see IncludeGraph::tokens_changed)
+    scan_includes();
+
     // Initialize file watcher
-    FileWatcher watcher(watch_paths);
+    FileWatcher watcher(get_watch_paths(), options.watcher);
+    watcher.set_debounce(options.debounce_ms, options.max_wait_ms);
     if (!watcher.initialize()) {
         std::cerr << "[ERROR] Failed to initialize file watcher." << std::endl;
         logger.log_error("Failed to initialize file watcher");
         return S_FAILURE;
     }
 
-    std::cout << "[INFO] Watching " << watcher.get_watched_files().size() << " file(s) for changes..." << std::endl;
-    std::cout << "[INFO] Poll interval: " << poll_interval_ms << " ms" << std::endl;
+    std::cout << "[INFO] Watching " << watcher.get_watched_count() << " file(s) for changes..." << std::endl;
+    metrics.set_watched_files(watcher.get_watched_count());
+    if (watcher.is_event_based()) {
+        std::cout << "[INFO] Change detection: inotify" << std::endl;
+    } else {
+        std::cout << "[INFO] Poll interval: " << options.poll_interval_ms << " ms" << std::endl;
+    }
     std::cout << "[INFO] Press Ctrl+C to stop daemon mode." << std::endl;
 
     // Set up signal handler for graceful shutdown
     std::signal(SIGINT, daemon_signal_handler);
     std::signal(SIGTERM, daemon_signal_handler);
+#ifndef _WIN32
+    // Clients that disconnect early must not end the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
 
     // Perform initial build
+    metrics_ = &metrics;
     std::cout << std::endl << "[INFO] Performing initial build..." << std::endl;
     logger.log_message("Performing initial build");
     logger.log_build_start();
     
     auto start_time = std::chrono::steady_clock::now();
-    E_RESULT build_result = build();
+    std::vector<uint32_t> completed;
+    ProgressBar::display_header();
+    E_RESULT build_result = build_platforms(get_target_platforms(), nullptr, &completed);
     auto end_time = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
     
     logger.log_build_end(build_result, duration);
+    metrics.record_build(build_result, duration / 1000.0);
     
     if (build_result == S_OK) {
         std::cout << "[SUCCESS] Initial build completed successfully." << std::endl;
     } else {
         std::cerr << "[ERROR] Initial build failed. Continuing to watch for changes..." << std::endl;
     }
+    for (uint32_t index : completed) {
+        start_test(*this, index);
+    }
+
+    // Changes are watched for while rebuilding as well. A rebuild whose actions are affected is
+    // cancelled and restarted, keeping the actions it already completed that are still valid.
+    runner_.set_process_groups(true);
+    runner_.set_background_priority(&background_priority);
+    const int building_poll_interval_ms = std::min(options.poll_interval_ms, 200);
+    std::vector<uint32_t> pending;
+
+    // Actions that changed, or failed, since they were last built successfully, and the
+    // actions whose last build failed (or was skipped because a dependency failed)
+    std::set<uint32_t> outdated;
+    std::set<uint32_t> failed;
+    std::sort(completed.begin(), completed.end());
+    for (uint32_t i = 0; i < plan_.actions().size(); ++i) {
+        if (!std::binary_search(completed.begin(), completed.end(), i)) {
+            outdated.insert(i);
+            failed.insert(i);
+        }
+    }
+
+    // Translation units affected by the changes not yet rebuilt, and the most recently edited file.
+    // Changes seen during a build are only ranked in the next cycle, so the set outlives the
+    // cycle arena below; its nodes come from a pool that reuses them once the set is cleared
+    std::pmr::unsynchronized_pool_resource edited_memory;
+    PathSet edited_sources(&edited_memory);
+    std::string latest_file;
+    long long latest_mtime = 0;
+
+    // Containers that only live for one cycle of the loop (a batch of changes and the rebuild it
+    // triggers) are allocated from an arena that is released as a whole when the next cycle
+    // starts, so a daemon running for days does not fragment the heap with them
+    constexpr size_t cycle_arena_size = 64 * 1024;
+    std::vector<std::byte> cycle_buffer(cycle_arena_size);
+    std::pmr::monotonic_buffer_resource cycle_memory(cycle_buffer.data(), cycle_buffer.size());
+    std::vector<uint32_t> ranks;
+
+    // A changed configuration is loaded into a new build system, which then replaces the active one
+    const BuildSystem* active = this;
+    std::unique_ptr<ProjectConfig> reloaded_config;
+    std::unique_ptr<BuildSystem> reloaded;
+    std::vector<Platform> platforms = get_target_platforms();
+
+    auto stamp_config_files = []() {
+        std::map<std::string, long long> stamps;
+        for (const std::string& file : ConfigParser::get_config_files()) {
+            stamps[file] = FileSystemUtils::get_modification_time(file);
+        }
+        return stamps;
+    };
+    std::map<std::string, long long> config_stamps = stamp_config_files();
+
+    // Replaces the active build system with one for the given configuration and
+    // returns the actions whose plan changed
+    auto switch_config = [&](std::unique_ptr<ProjectConfig> config) {
+        auto system = std::make_unique<BuildSystem>(*config);
+        system->set_jobs(jobs_);
+        system->runner_.set_process_groups(true);
+        system->runner_.set_background_priority(&background_priority);
+        system->metrics_ = &metrics;
+        std::vector<uint32_t> changed = system->get_changed_actions(active->plan_);
+
+        // Outdated and failed actions keep their state in the new plan
+        auto carry_over = [&](const std::set<uint32_t>& indices) {
+            std::set<uint32_t> mapped;
+            for (uint32_t index : indices) {
+                const BuildAction& previous = active->plan_.actions()[index];
+                for (uint32_t i = 0; i < system->plan_.actions().size(); ++i) {
+                    const BuildAction& action = system->plan_.actions()[i];
+                    if (action.kind == previous.kind && action.target == previous.target && action.platform == previous.platform) {
+                        mapped.insert(i);
+                    }
+                }
+            }
+            return mapped;
+        };
+        outdated = carry_over(outdated);
+        outdated.insert(changed.begin(), changed.end());
+        failed = carry_over(failed);
+
+        // The previous build system is released before the configuration it refers to
+        reloaded = std::move(system);
+        reloaded_config = std::move(config);
+        active = reloaded.get();
+        active->scan_includes();
+        platforms = active->get_target_platforms();
+        watcher.set_watch_paths(active->get_watch_paths());
+        metrics.set_watched_files(watcher.get_watched_count());
+        return changed;
+    };
+
+    // Source lists refreshed for created or deleted files, applied once no build is pending
+    std::unique_ptr<ProjectConfig> refreshed_config;
+
+    // Loads the changed configuration and returns the actions whose plan changed
+    auto reload_config = [&]() {
+        std::cout << std::endl << "[CONFIG CHANGED] Reloading configuration..." << std::endl;
+        logger.log_message("Configuration changed, reloading");
+
+        auto config = std::make_unique<ProjectConfig>(ConfigParser::load_project_config(".bodge"));
+        config_stamps = stamp_config_files();
+        if (!config->is_valid()) {
+            std::cerr << "[ERROR] Changed configuration is invalid, keeping the previous one." << std::endl;
+            logger.log_error("Changed configuration is invalid");
+            return std::vector<uint32_t>();
+        }
+        ConfigParser::resolve_all_sources(*config);
+        check_tests(*config);
+
+        // The reloaded configuration already lists the current source files
+        refreshed_config.reset();
+        std::vector<uint32_t> changed = switch_config(std::move(config));
+        std::cout << "[INFO] " << changed.size() << " action(s) changed" << std::endl;
+        return changed;
+    };
+
+    // When the first change not yet rebuilt was seen, for the change-to-build-start latency
+    std::optional<std::chrono::steady_clock::time_point> first_change;
+
+    // Reports the changes the watcher found and resolves them to the affected actions. Created or
+    // deleted files matching source patterns update the source lists; while building, the indices
+    // of the running plan must stay valid, so the new lists are only applied when idle.
+    auto collect_changes = [&](bool idle) {
+        // Not on the cycle arena: the watcher, the log, the source lists and the include graph all
+        // take the batch as std::vector; it is freed as soon as the batch is resolved
+        std::vector<std::string> changed_files = watcher.get_changed_files();
+        logger.log_changed_files(changed_files);
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << std::endl << "[CHANGE DETECTED] " << changed_files.size()
+                      << " file(s) changed:" << std::endl;
+            for (const std::string& file : changed_files) {
+                std::cout << "  - " << file << std::endl;
+            }
+        }
+
+        // The configuration is only copied when source files were created or deleted
+        const ProjectConfig& current = refreshed_config ? *refreshed_config : active->config_;
+        if (ConfigParser::sources_outdated(current, changed_files)) {
+            auto config = std::make_unique<ProjectConfig>(current);
+            if (ConfigParser::refresh_sources(*config, changed_files)) {
+                refreshed_config = std::move(config);
+            }
+        }
+        std::vector<uint32_t> affected;
+        if (idle && refreshed_config) {
+            affected = switch_config(std::move(refreshed_config));
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << "[INFO] Source files were added or removed, " << affected.size() << " action(s) changed"
+                      << std::endl;
+        }
+
+        // Headers whose tokens are unchanged, e.g. after editing only comments, are not recompiled
+        PathSet formatting_only(&cycle_memory);
+        for (const std::string& file : changed_files) {
+            if (FileSystemUtils::is_cpp_header_file(file) && !IncludeGraph::tokens_changed(file, options.line_sensitive)) {
+                formatting_only.emplace(file);
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "[INFO] Only comments or formatting changed in " << file << ", not recompiling";
+                if (!options.line_sensitive) {
+                    std::cout << " (__LINE__ may be stale; use --line-sensitive to rebuild when lines move)";
+                }
+                std::cout << std::endl;
+            }
+        }
+
+        // Resolve the changes through the include graph to the affected targets and their dependents
+        PathSet affected_sources(&cycle_memory);
+        std::vector<uint32_t> dependent = active->get_affected_actions(changed_files, affected_sources, &formatting_only);
+        edited_sources.insert(affected_sources.begin(), affected_sources.end());
+        for (const std::string& file : changed_files) {
+            if (formatting_only.count(file) != 0) {
+                continue;
+            }
+            FileStamp stamp;
+            if (FileSystemUtils::get_file_stamp(file, stamp) && (latest_file.empty() || stamp.mtime >= latest_mtime)) {
+                latest_file = file;
+                latest_mtime = stamp.mtime;
+            }
+        }
+        affected.insert(affected.end(), dependent.begin(), dependent.end());
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        outdated.insert(affected.begin(), affected.end());
+        // Tests of targets that have to be rebuilt would report stale results
+        for (uint32_t index : affected) {
+            tests.cancel(TestRunner::get_test_name(active->plan_.actions()[index]));
+        }
+        metrics.set_watched_files(watcher.get_watched_count());
+        if (!affected.empty() && !first_change) {
+            first_change = watcher.get_batch_start();
+        }
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << "[INFO] " << affected_sources.size() << " translation unit(s) affected" << std::endl;
+        return affected;
+    };
+
+    // Build request of another bodge process (see request_daemon_build), answered once the
+    // daemon is idle; while it is served, build output goes to the requesting process
+    int client = -1;
+    std::string client_request;
+    bool serving = false;
+
+    auto finish_request = [&](const std::string& message, E_RESULT result) {
+        DaemonSocket::write_all(client, message + DaemonSocket::RESULT_MARKER + std::to_string(result) + "\n");
+        DaemonSocket::close_connection(client);
+        client = -1;
+        serving = false;
+    };
+
+    // Resolves the request to the target actions it names and everything they depend on
+    auto resolve_request = [&](std::vector<uint32_t>& requested, std::string& message) {
+        size_t first = client_request.find('\t');
+        size_t second = first == std::string::npos ? first : client_request.find('\t', first + 1);
+        if (second == std::string::npos || client_request.compare(0, first, "build") != 0) {
+            message = "[ERROR] Unsupported daemon request.\n";
+            return S_ERROR_INVALID_ARGUMENT;
+        }
+        std::string target_name = client_request.substr(first + 1, second - first - 1);
+        std::string platform_name = client_request.substr(second + 1);
+
+        const std::vector<BuildAction>& actions = active->plan_.actions();
+        std::vector<uint32_t> selected;
+        for (uint32_t i = 0; i < actions.size(); ++i) {
+            const BuildAction& action = actions[i];
+            bool platform_matches = platform_name.empty()
+                ? std::find(platforms.begin(), platforms.end(), action.platform) != platforms.end()
+                : action.platform.to_string() == platform_name;
+            if (action.kind == ActionKind::TARGET && platform_matches && (target_name.empty() || action.target == target_name)) {
+                selected.push_back(i);
+            }
+        }
+        if (selected.empty()) {
+            auto it = active->config_.targets.find(target_name);
+            if (it != active->config_.targets.end() &&
+                !it->second.should_build_for_platform(Platform::from_string(platform_name))) {
+                message = "[INFO] Skipping target '" + target_name + "' - not configured for platform " + platform_name + "\n";
+                return S_OK;
+            }
+            message = "[ERROR] The daemon does not build " +
+                      (target_name.empty() ? std::string("any target") : "target '" + target_name + "'") +
+                      (platform_name.empty() ? "" : " for platform " + platform_name) + ".\n";
+            return S_TARGET_NOT_FOUND;
+        }
+
+        std::set<uint32_t> needed(selected.begin(), selected.end());
+        while (!selected.empty()) {
+            uint32_t index = selected.back();
+            selected.pop_back();
+            for (uint32_t dependency : actions[index].deps) {
+                if (needed.insert(dependency).second) {
+                    selected.push_back(dependency);
+                }
+            }
+        }
+        requested.assign(needed.begin(), needed.end());
+        return S_OK;
+    };
+
+    // Host processes that reload shared library targets after they are rebuilt subscribe with
+    // "reload<TAB>target<TAB>platform"; without a platform, the library of the first platform is used
+    LibraryReloader reloader;
+    auto subscribe_host = [&]() {
+        std::vector<std::string> fields = StringUtils::split(client_request, '\t');
+        std::string platform_name = fields.size() > 2 ? fields[2] : platforms.empty() ? "" : platforms.front().to_string();
+        const BuildAction* library = nullptr;
+        for (const BuildAction& action : active->plan_.actions()) {
+            if (action.kind == ActionKind::TARGET && fields.size() > 1 && action.target == fields[1] &&
+                action.platform.to_string() == platform_name) {
+                library = &action;
+            }
+        }
+        if (library == nullptr || library->type != BuildType::SHARED_LIBRARY) {
+            DaemonSocket::write_all(client, "error\tThe daemon does not build a shared library '" +
+                                                (fields.size() > 1 ? fields[1] : "") + "' for platform " + platform_name + "\n");
+            DaemonSocket::close_connection(client);
+        } else if (reloader.subscribe(client, *library)) {
+            std::cout << "[INFO] Live reload: a host process subscribed to " << library->target << std::endl;
+            logger.log_message("Host process subscribed to " + library->target);
+        }
+        client = -1;
+    };
+
+    // Answers the request right away if its actions are up to date, otherwise returns the outdated ones
+    auto serve_request = [&]() {
+        std::vector<uint32_t> requested;
+        std::string message;
+        E_RESULT result = resolve_request(requested, message);
+        std::vector<uint32_t> needed;
+        for (uint32_t index : requested) {
+            if (outdated.count(index) != 0) {
+                needed.push_back(index);
+            }
+        }
+        if (result == S_OK && !requested.empty()) {
+            metrics.record_cache_lookup("daemon_requests", needed.empty());
+        }
+        if (!needed.empty()) {
+            std::cout << std::endl << "[INFO] Build requested by another bodge process" << std::endl;
+            logger.log_message("Build requested by another bodge process");
+            serving = true;
+        } else {
+            if (result == S_OK && message.empty()) {
+                message = "[INFO] Daemon: " + std::to_string(requested.size()) + " action(s) up to date.\n";
+            }
+            finish_request(message, result);
+        }
+        return needed;
+    };
 
     // Main daemon loop
     std::cout << std::endl << "[INFO] Daemon is now watching for file changes..." << std::endl;
     
     while (!daemon_should_stop) {
-        // Wait for the specified interval
-        std::this_thread::sleep_for(std::chrono::milliseconds(poll_interval_ms));
+        cycle_memory.release();
+        if (pending.empty() && refreshed_config && stamp_config_files() == config_stamps) {
+            // Files were created or deleted during the last build
+            pending = switch_config(std::move(refreshed_config));
+            std::cout << std::endl << "[INFO] Source files were added or removed, " << pending.size()
+                      << " action(s) changed" << std::endl;
+            if (pending.empty()) {
+                std::cout << std::endl << "[INFO] Watching for file changes..." << std::endl;
+                continue;
+            }
+        } else if (pending.empty() && stamp_config_files() != config_stamps) {
+            pending = reload_config();
+            if (pending.empty()) {
+                std::cout << std::endl << "[INFO] Watching for file changes..." << std::endl;
+                continue;
+            }
+        } else if (pending.empty()) {
+            // Build requests are accepted between waits for file changes; when polling, waiting
+            // for a request replaces the sleep between polls
+            if (client < 0) {
+                client = control_socket.accept_client(watcher.is_event_based() ? 0 : options.poll_interval_ms);
+                if (client >= 0 && !DaemonSocket::read_line(client, client_request)) {
+                    DaemonSocket::close_connection(client);
+                    client = -1;
+                } else if (client >= 0 && client_request.compare(0, 7, "reload\t") == 0) {
+                    subscribe_host();
+                }
+            }
 
-        // Check for file changes
-        if (watcher.has_changes()) {
-            std::vector<std::string> changed_files = watcher.get_changed_files();
-            
-            std::cout << std::endl << "[CHANGE DETECTED] " << changed_files.size() 
-                      << " file(s) changed:" << std::endl;
-            logger.log_changed_files(changed_files);
-            
-            for (const std::string& file : changed_files) {
-                std::cout << "  - " << file << std::endl;
+            // Wait for file changes; with inotify this returns as soon as a file changes. A request
+            // is answered after the changes made before it are built
+            int wait_ms = client >= 0 || !watcher.is_event_based() ? 0 : building_poll_interval_ms;
+            if (watcher.wait_for_changes(wait_ms)) {
+                pending = collect_changes(true);
+                if (pending.empty()) {
+                    std::cout << "[INFO] No planned target uses the changed files, nothing to rebuild." << std::endl;
+                    logger.log_message("No targets affected");
+                    std::cout << std::endl << "[INFO] Watching for file changes..." << std::endl;
+                }
+            }
+            if (pending.empty() && client >= 0) {
+                pending = serve_request();
             }
+            if (pending.empty()) {
+                continue;
+            }
+        }
 
-            // Small delay to allow file writes to complete
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::string affected_names;
+        for (uint32_t index : pending) {
+            const BuildAction& action = active->plan_.actions()[index];
+            affected_names += (affected_names.empty() ? "" : ", ") + action.target;
+            if (action.kind == ActionKind::TARGET) {
+                affected_names += " (" + action.platform.to_string() + ")";
+            }
+        }
 
-            // Trigger rebuild
-            std::cout << std::endl << "[INFO] Triggering rebuild..." << std::endl;
-            logger.log_build_start();
-            
-            start_time = std::chrono::steady_clock::now();
-            build_result = build();
-            end_time = std::chrono::steady_clock::now();
-            duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            
-            logger.log_build_end(build_result, duration);
-            
-            if (build_result == S_OK) {
-                std::cout << "[SUCCESS] Rebuild completed successfully." << std::endl;
-            } else {
-                std::cerr << "[ERROR] Rebuild failed. See log for details." << std::endl;
+        // Trigger rebuild
+        std::cout << std::endl << "[INFO] Triggering rebuild of " << pending.size() << " action(s): "
+                  << affected_names << std::endl;
+        logger.log_message("Rebuilding " + affected_names);
+        logger.log_build_start();
+
+        if (first_change) {
+            std::chrono::duration<double> latency = std::chrono::steady_clock::now() - *first_change;
+            metrics.record_change_latency(latency.count());
+            first_change.reset();
+        }
+        metrics.set_queue_depth(pending.size());
+
+        // The action containing the most recently edited file is started first, then the others
+        // with edited sources and those that failed last time, so their errors show up early
+        ranks.assign(active->plan_.actions().size(), 2);
+        PathSet latest_sources(&cycle_memory);
+        if (!latest_file.empty()) {
+            active->get_affected_actions({latest_file}, latest_sources);
+        }
+        for (uint32_t i = 0; i < ranks.size(); ++i) {
+            if (failed.count(i) != 0) {
+                ranks[i] = 1;
             }
+            for (const std::string& input : active->plan_.actions()[i].inputs) {
+                if (latest_sources.count(input) != 0) {
+                    ranks[i] = 0;
+                } else if (edited_sources.count(input) != 0) {
+                    ranks[i] = std::min(ranks[i], 1u);
+                }
+            }
+        }
+        // Dependencies are as urgent as their most urgent dependent; they come first in the plan
+        for (size_t i = ranks.size(); i-- > 0;) {
+            for (uint32_t dependency : active->plan_.actions()[i].deps) {
+                ranks[dependency] = std::min(ranks[dependency], ranks[i]);
+            }
+        }
+        // Builds requested from another terminal are waited for as a whole
+        if (serving) {
+            std::fill(ranks.begin(), ranks.end(), 0);
+        }
+        edited_sources.clear();
+        latest_file.clear();
 
-            // Update file watcher state
-            watcher.update_state();
-            
+        completed.clear();
+        std::atomic<bool> finished(false);
+        active->runner_.reset();
+        start_time = std::chrono::steady_clock::now();
+        std::thread build_thread([&]() {
+            // Only the build's output goes to the client, not that of tests running meanwhile
+            if (serving) {
+                DaemonSocket::redirect_output(client);
+            }
+            ProgressBar::display_header();
+            build_result = active->build_platforms(platforms, &pending, &completed, &ranks);
+            if (serving) {
+                DaemonSocket::redirect_output(-1);
+            }
+            finished = true;
+        });
+
+        // Targets are tested as soon as they are built, unless they changed again in the meantime
+        std::pmr::set<uint32_t> queued(&cycle_memory);
+        size_t tested = 0;
+        auto start_tests = [&]() {
+            std::unique_lock<std::mutex> lock(output_mutex);
+            std::vector<uint32_t> built(completed.begin() + tested, completed.end());
+            tested = completed.size();
+            lock.unlock();
+            for (uint32_t index : built) {
+                if (queued.count(index) == 0) {
+                    start_test(*active, index);
+                }
+            }
+        };
+
+        while (!finished) {
+            start_tests();
+            if (daemon_should_stop) {
+                active->runner_.cancel();
+                break;
+            }
+            if (!watcher.wait_for_changes(building_poll_interval_ms)) {
+                continue;
+            }
+
+            std::vector<uint32_t> affected = collect_changes(false);
+            queued.insert(affected.begin(), affected.end());
+            metrics.set_queue_depth(pending.size() + std::count_if(queued.begin(), queued.end(), [&](uint32_t index) {
+                return !std::binary_search(pending.begin(), pending.end(), index);
+            }));
+            bool restart = std::any_of(affected.begin(), affected.end(), [&](uint32_t index) {
+                return std::binary_search(pending.begin(), pending.end(), index);
+            });
+            if (restart && !active->runner_.is_cancelled()) {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::cout << "[INFO] Inputs of the running build changed, cancelling it..." << std::endl;
+                active->runner_.cancel();
+            }
+        }
+        build_thread.join();
+        start_tests();
+        end_time = std::chrono::steady_clock::now();
+        duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        metrics.record_build(build_result, duration / 1000.0);
+
+        // Completed actions are up to date unless they changed again while building. Rebuilt
+        // libraries are sent to their hosts even if the build as a whole failed or was cancelled
+        std::sort(completed.begin(), completed.end());
+        for (uint32_t index : completed) {
+            if (queued.count(index) == 0) {
+                outdated.erase(index);
+            }
+            failed.erase(index);
+            reloader.publish(active->plan_.actions()[index]);
+        }
+        if (build_result != S_CANCELLED) {
+            for (uint32_t index : pending) {
+                if (!std::binary_search(completed.begin(), completed.end(), index)) {
+                    failed.insert(index);
+                }
+            }
+        }
+
+        if (build_result == S_CANCELLED) {
+            // Completed actions stay valid unless the new changes affect them again
+            logger.log_message("Build cancelled after " + std::to_string(duration) + "ms");
+            for (uint32_t index : pending) {
+                if (!std::binary_search(completed.begin(), completed.end(), index)) {
+                    queued.insert(index);
+                }
+            }
+            pending.assign(queued.begin(), queued.end());
+            continue;
+        }
+
+        logger.log_build_end(build_result, duration);
+        
+        if (build_result == S_OK) {
+            std::cout << "[SUCCESS] Rebuild completed successfully." << std::endl;
+        } else {
+            std::cerr << "[ERROR] Rebuild failed. See log for details." << std::endl;
+        }
+        if (serving) {
+            finish_request("", build_result);
+        }
+
+        // Changes that did not affect the finished build are built next
+        pending.assign(queued.begin(), queued.end());
+        metrics.set_queue_depth(pending.size());
+        if (pending.empty()) {
             std::cout << std::endl << "[INFO] Watching for file changes..." << std::endl;
         }
     }
 
     // Daemon was interrupted
+    if (client >= 0) {
+        finish_request("[ERROR] The daemon was stopped.\n", S_CANCELLED);
+    }
+    metrics_ = nullptr;
+    runner_.set_background_priority(nullptr);
     std::cout << std::endl << "[INFO] Daemon mode stopped." << std::endl;
     logger.log_message("Daemon mode stopped by user");
 
     return S_OK;
-}
\ No newline at end of file
+}
+
+E_RESULT BuildSystem::request_daemon_build(int connection, const std::string& target_name, const std::string& platform) {
+    E_RESULT result = S_FAILURE;
+    bool finished = false;
+    if (DaemonSocket::write_all(connection, "build\t" + target_name + "\t" + platform + "\n")) {
+        // Output is printed as it arrives, up to the result line that ends it
+        std::string data;
+        while (!finished && DaemonSocket::read_available(connection, data)) {
+            size_t marker = data.find(DaemonSocket::RESULT_MARKER);
+            std::cout << data.substr(0, marker) << std::flush;
+            if (marker == std::string::npos) {
+                data.clear();
+                continue;
+            }
+            data.erase(0, marker);
+            if (data.find('\n') != std::string::npos) {
+                result = static_cast<E_RESULT>(std::atoi(data.c_str() + 1));
+                finished = true;
+            }
+        }
+    }
+    DaemonSocket::close_connection(connection);
+
+    if (!finished) {
+        std::cerr << "[ERROR] Lost the connection to the daemon." << std::endl;
+        return S_FAILURE;
+    }
+    return result;
+}
@@ -4,9 +4,46 @@
 #define BUILD_SYSTEM_H
 
 #include "ProjectConfig.h"
+#include "BuildPlan.h"
+#include "FileWatcher.h"
+#include "ProcessRunner.h"
+#include "JobPriority.h"
+#include "DaemonMetrics.h"
 #include "git.h"
 #include "core.h"
+#include <memory_resource>
+#include <set>
 #include <string>
+#include <string_view>
+
+/**
+ * @brief Orders paths of any string type, so path sets can be searched without converting
+ */
+struct PathLess {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const { return a < b; }
+};
+
+/**
+ * @brief Set of paths whose nodes and strings come from the memory resource it is created with
+ */
+using PathSet = std::pmr::set<std::pmr::string, PathLess>;
+
+/**
+ * @brief Settings of daemon (watch) mode
+ */
+struct DaemonOptions {
+    int poll_interval_ms = 1000;                    // Interval between file checks when polling
+    std::string log_file = "bodge_daemon.log";      // Build log
+    WatcherBackend watcher = WatcherBackend::AUTO;  // How file changes are detected
+    int debounce_ms = 100;                          // Quiet period that ends a batch of changes
+    int max_wait_ms = 2000;                         // Longest time a batch of changes is held back
+    std::string metrics_host = "127.0.0.1";         // Address the metrics endpoint listens on
+    int metrics_port = 0;                           // Port of the metrics endpoint (0: disabled)
+    BackgroundSettings background;                  // Priority of jobs nobody is waiting for
+    bool line_sensitive = false;                    // Header edits that move tokens to other lines count as changes
+                                                    // (off: fewer rebuilds, but __LINE__ may be stale)
+};
 
 /**
  * @brief The main build system class that handles compilation
@@ -14,10 +51,11 @@
 class BuildSystem {
 public:
     /**
-     * @brief Constructor that takes the loaded configuration
-     * @param config The project configuration to use for building
+     * @brief Constructor that takes the loaded configuration and creates the build plan
+     * @param config The project configuration to use for building (must outlive the build system)
+     * @param platforms Platforms to plan for in addition to the configured default platforms
      */
-    explicit BuildSystem(const ProjectConfig& config);
+    explicit BuildSystem(const ProjectConfig& config, const std::vector<Platform>& platforms = {});
 
     /**
      * @brief Main function to construct and execute the build command
@@ -25,6 +63,19 @@ public:
      */
     E_RESULT build() const;
 
+    /**
+     * @brief Builds all planned targets for one platform
+     * @param platform Target platform to build for (must be part of the plan)
+     * @return S_OK if build was successful, S_BUILD_FAILED otherwise
+     */
+    E_RESULT build_for_platform(const Platform& platform) const;
+
+    /**
+     * @brief Sets how many build actions may run at the same time
+     * @param jobs Maximum number of concurrent actions (0 for the number of CPU cores)
+     */
+    void set_jobs(int jobs);
+
     /**
      * @brief Builds git dependencies specified in the configuration
      * @return S_OK if all dependencies were successfully handled, S_BUILD_FAILED otherwise
@@ -53,17 +104,39 @@ public:
      */
     E_RESULT execute_sequence(const std::string& sequence_name) const;
 
+    /**
+     * @brief Writes the build plan and sequences as a build.ninja file
+     * @param filename Path of the ninja file
+     * @param config_files Configuration files that trigger regeneration when changed
+     * @param regenerate_command Command ninja runs to regenerate the file
+     * @param platforms Platforms to export (empty for the configured default platforms)
+     * @return S_OK if the file was written, S_FILE_OPERATION_FAILED otherwise
+     */
+    E_RESULT generate_ninja(const std::string& filename, const std::vector<std::string>& config_files,
+                            const std::string& regenerate_command, const std::vector<Platform>& platforms = {}) const;
+
     /**
      * @brief Runs the build system in daemon mode (watches for file changes)
-     * @param poll_interval_ms Interval in milliseconds between file checks (default: 1000ms)
-     * @param log_file Path to log file (default: "bodge_daemon.log")
+     * @param options Daemon settings
      * @return S_OK if daemon started successfully (runs indefinitely until interrupted)
      */
-    E_RESULT run_daemon_mode(int poll_interval_ms = 1000, const std::string& log_file = "bodge_daemon.log") const;
+    E_RESULT run_daemon_mode(const DaemonOptions& options = DaemonOptions()) const;
 
-private:
-    const ProjectConfig config_;
+    /**
+     * @brief Lets the daemon running for the project perform a build, printing its output
+     * @param connection Connection to the daemon (see DaemonSocket::connect), closed afterwards
+     * @param target_name Target to build, or empty for all targets
+     * @param platform Platform to build for, or empty for the daemon's platforms
+     * @return Result of the build, S_FAILURE if the connection was lost
+     */
+    static E_RESULT request_daemon_build(int connection, const std::string& target_name, const std::string& platform);
 
+private:
+    const ProjectConfig& config_;
+    BuildPlan plan_;
+    int jobs_;
+    mutable ProcessRunner runner_;  // Runs build commands; lets daemon mode cancel a running build
+    mutable DaemonMetrics* metrics_ = nullptr;  // Receives action results while daemon mode runs
 
     /**
      * @brief Performs pre-build checks
@@ -71,39 +144,78 @@ private:
      */
     E_RESULT prebuild_checks() const;
 
-    /**
-     * @brief Constructs the complete compiler command string
-     * @return The complete build command as a string
-     */
-    std::string generate_command() const;
-
     /**
      * @brief Executes the build command and handles output
      * @param command The command to execute
+     * @param background true to run the command with the background priority
      * @return S_OK if execution was successful, S_COMMAND_EXECUTION_FAILED otherwise
      */
-    E_RESULT execute_command(const std::string& command) const;
+    E_RESULT execute_command(const std::string& command, bool background = false) const;
 
     /**
-     * @brief Validates that the system can execute commands
-     * @return S_OK if system command execution is supported, S_FAILURE otherwise
+     * @brief Builds all planned targets for a set of platforms
+     * @param platforms Platforms to build for
+     * @param actions Plan actions to restrict the build to (nullptr for all targets)
+     * @param completed Receives the actions that succeeded (optional)
+     * @param ranks Rank of every plan action; lower ranks are started first, and actions ranked above
+     *              0 run with the background priority (nullptr for plan order)
+     * @return S_OK if build was successful, S_CANCELLED if it was cancelled, S_BUILD_FAILED otherwise
      */
-    E_RESULT validate_system_support() const;
-    
+    E_RESULT build_platforms(const std::vector<Platform>& platforms, const std::vector<uint32_t>* actions = nullptr,
+                             std::vector<uint32_t>* completed = nullptr,
+                             const std::vector<uint32_t>* ranks = nullptr) const;
+
     /**
-     * @brief Generates build command for a specific target
-     * @param target The target to generate command for
-     * @return The complete build command as a string
+     * @brief Finds the actions that must run again after files changed
+     * @param changed_files Paths of the changed files
+     * @param affected_sources Receives the translation units that are changed or include a changed file
+     * @param formatting_only Changed headers whose tokens are unchanged; only rule actions depend on them
+     * @return Indices of the affected actions and all actions depending on them
      */
-    std::string generate_target_command(const BuildTarget& target) const;
-    
+    std::vector<uint32_t> get_affected_actions(const std::vector<std::string>& changed_files,
+                                               PathSet& affected_sources,
+                                               const PathSet* formatting_only = nullptr) const;
+
+    /**
+     * @brief Scans the headers included by all compiled sources, so the tokens of a header
+     *        are known before it is edited for the first time
+     */
+    void scan_includes() const;
+
+    /**
+     * @brief Collects the files and directories daemon mode watches
+     * @return Sources and include directories of every planned action
+     */
+    std::vector<std::string> get_watch_paths() const;
+
+    /**
+     * @brief Compares the plan with the plan of a previous configuration
+     * @param previous Plan before the configuration changed
+     * @return Indices of the actions that are new or differ from their previous version, and their dependents
+     */
+    std::vector<uint32_t> get_changed_actions(const BuildPlan& previous) const;
+
+    /**
+     * @brief Executes a planned build action
+     * @param action The action to execute
+     * @param background true to run the action with the background priority
+     * @return S_OK if the build was successful, an error code otherwise
+     */
+    E_RESULT execute_action(const BuildAction& action, bool background = false) const;
+
     /**
-     * @brief Generates build command for a specific target and platform
-     * @param target The target to generate command for
-     * @param platform The platform to build for
-     * @return The complete build command as a string
+     * @brief Runs a generator rule unless its outputs are up to date
+     * @param action The rule action
+     * @param background true to run the rule with the background priority
+     * @return S_OK if the outputs are up to date or were generated
      */
-    std::string generate_target_command_for_platform(const BuildTarget& target, const Platform& platform) const;
+    E_RESULT execute_rule(const BuildAction& action, bool background = false) const;
+
+    /**
+     * @brief Validates that the system can execute commands
+     * @return S_OK if system command execution is supported, S_FAILURE otherwise
+     */
+    E_RESULT validate_system_support() const;
     
     /**
      * @brief Gets the platforms to build for (either from config or current platform)
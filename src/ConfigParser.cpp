@@ -1,12 +1,84 @@
 #include "ConfigParser.h"
 #include "StringUtils.h"
 #include "FileSystemUtils.h"
+#include "ConfigSnapshot.h"
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#include <set>
+#include <filesystem>
+#include <algorithm>
+
+std::string ConfigParser::config_file_;
+std::string ConfigParser::config_content_;
+DirectoryStamps ConfigParser::config_files_;
+DirectoryStamps ConfigParser::scanned_dirs_;
+std::vector<std::string> ConfigParser::workspace_projects_;
+
+namespace {
+    // Snapshot key used instead of a file name when loading a workspace
+    const char* WORKSPACE_KEY = "<workspace>";
+
+    // Makes a path from a sub-project's .bodge relative to the main project
+    std::string prefix_path(const std::string& base_dir, const std::string& path) {
+        if (path.empty() || std::filesystem::path(path).is_absolute()) {
+            return path;
+        }
+        if (path == ".") {
+            return base_dir;
+        }
+        return base_dir + "/" + (path.compare(0, 2, "./") == 0 ? path.substr(2) : path);
+    }
+
+    void prefix_paths(const std::string& base_dir, std::vector<std::string>& paths) {
+        for (std::string& path : paths) {
+            path = prefix_path(base_dir, path);
+        }
+    }
+
+    void prefix_platform_config(const std::string& base_dir, PlatformConfig& plat_config) {
+        prefix_paths(base_dir, plat_config.source_patterns);
+        prefix_paths(base_dir, plat_config.include_dirs);
+        prefix_paths(base_dir, plat_config.library_dirs);
+    }
+
+    // Checks if a resolved source list misses a created file or still lists a deleted one
+    template <typename List>
+    bool source_list_outdated(const List& list, const std::vector<std::string>& changed_files) {
+        if (!list.sources_resolved) {
+            return false;
+        }
+        for (const std::string& file : changed_files) {
+            bool exists = FileSystemUtils::file_exists(file);
+            bool covered = !exists || std::any_of(list.source_patterns.begin(), list.source_patterns.end(),
+                                                  [&](const std::string& pattern) {
+                return FileSystemUtils::pattern_covers(pattern, file);
+            });
+            if (!covered) {
+                continue;
+            }
+            std::string normalized = FileSystemUtils::normalize_path(file);
+            bool listed = std::any_of(list.sources.begin(), list.sources.end(), [&](const std::string& source) {
+                return FileSystemUtils::normalize_path(source) == normalized;
+            });
+            if (listed != exists) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Include directories of the sources every target gets for a platform
+    std::vector<std::string> global_include_dirs(const ProjectConfig& config, const PlatformConfig& plat_config) {
+        std::vector<std::string> dirs = config.global_include_dirs;
+        dirs.insert(dirs.end(), plat_config.include_dirs.begin(), plat_config.include_dirs.end());
+        return dirs;
+    }
+}
 
 ProjectConfig ConfigParser::load_project_config(const std::string& filename) {
     ProjectConfig config;
-    std::ifstream file(filename);
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
 
     if (!file.is_open()) {
         std::cerr << "[FATAL] Could not open configuration file: " << filename 
@@ -14,17 +86,204 @@ ProjectConfig ConfigParser::load_project_config(const std::string& filename) {
         return config; // Return empty config
     }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        process_config_line(line, config);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+
+    config_file_ = filename;
+    config_content_ = content;
+    config_files_.clear();
+    scanned_dirs_.clear();
+
+    // Reuse the configuration parsed by an earlier run if the file and the .bodge files of
+    // its dependencies are unchanged, together with whatever sources that run expanded
+    if (ConfigSnapshot::load(filename, content, config, config_files_, scanned_dirs_)) {
+        return config;
     }
 
+    parse_content(content, config);
+
     // Apply default values for missing configuration
     config.apply_defaults();
+
+    load_dependency_projects(config);
+
+    // Sources are expanded lazily, only for the targets a command actually needs
+    ConfigSnapshot::save(filename, content, config, config_files_, scanned_dirs_);
     
     return config;
 }
 
+ProjectConfig ConfigParser::load_workspace() {
+    ProjectConfig config;
+
+    // Every directory below the current one (except hidden ones) with a .bodge file is a project
+    std::vector<std::string> project_dirs;
+    try {
+        std::filesystem::recursive_directory_iterator it(".", std::filesystem::directory_options::skip_permission_denied);
+        for (; it != std::filesystem::recursive_directory_iterator(); ++it) {
+            if (!it->is_directory()) {
+                continue;
+            }
+            if (it->path().filename().string()[0] == '.') {
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (std::filesystem::is_regular_file(it->path() / ".bodge")) {
+                project_dirs.push_back(std::filesystem::relative(it->path(), ".").generic_string());
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "[ERROR] Failed to scan workspace: " << e.what() << std::endl;
+    }
+    std::sort(project_dirs.begin(), project_dirs.end());
+    workspace_projects_ = project_dirs;
+
+    // The snapshot is keyed by the list of projects and all of their content
+    std::vector<std::string> contents;
+    std::string root_content = read_file(".bodge");
+    std::string workspace_content = root_content;
+    for (const std::string& dir : project_dirs) {
+        contents.push_back(read_file(dir + "/.bodge"));
+        workspace_content += '\0' + dir + '\0' + contents.back();
+    }
+
+    config_file_ = WORKSPACE_KEY;
+    config_content_ = workspace_content;
+    config_files_.clear();
+    scanned_dirs_.clear();
+
+    if (ConfigSnapshot::load(config_file_, config_content_, config, config_files_, scanned_dirs_)) {
+        return config;
+    }
+
+    // A .bodge in the workspace root is the main project, its targets are not namespaced
+    parse_content(root_content, config);
+    if (config.name.empty()) {
+        config.name = "workspace";
+    }
+    config.apply_defaults();
+
+    for (size_t i = 0; i < project_dirs.size(); ++i) {
+        ProjectConfig sub;
+        parse_content(contents[i], sub);
+        sub.apply_defaults();
+        merge_subproject(config, sub, project_dirs[i]);
+    }
+
+    ConfigSnapshot::save(config_file_, config_content_, config, config_files_, scanned_dirs_);
+    return config;
+}
+
+const std::vector<std::string>& ConfigParser::get_workspace_projects() {
+    return workspace_projects_;
+}
+
+std::vector<std::string> ConfigParser::get_config_files() {
+    std::vector<std::string> files;
+    if (config_file_ != WORKSPACE_KEY) {
+        files.push_back(config_file_);
+    }
+    for (const auto& [path, mtime] : config_files_) {
+        files.push_back(path);
+    }
+    return files;
+}
+
+bool ConfigParser::sources_outdated(const ProjectConfig& config, const std::vector<std::string>& changed_files) {
+    for (const auto& [name, target] : config.targets) {
+        if (source_list_outdated(target, changed_files)) {
+            return true;
+        }
+        for (const auto& [platform, plat_config] : target.platform_configs) {
+            if (source_list_outdated(plat_config, changed_files)) {
+                return true;
+            }
+        }
+    }
+    for (const auto& [platform, plat_config] : config.global_platform_configs) {
+        if (source_list_outdated(plat_config, changed_files)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConfigParser::refresh_sources(ProjectConfig& config, const std::vector<std::string>& changed_files) {
+    bool changed = false;
+    auto refresh = [&](auto& list, const std::vector<std::string>& include_dirs, bool generated) {
+        if (!source_list_outdated(list, changed_files)) {
+            return;
+        }
+        list.sources_resolved = false;
+        expand_sources(list.source_patterns, list.sources, list.sources_resolved, include_dirs);
+        if (generated) {
+            add_generated_sources(config, list.source_patterns, list.sources);
+        }
+        changed = true;
+    };
+
+    // Sources shared by all platforms are only ordered by the include directories of all platforms
+    for (auto& [name, target] : config.targets) {
+        refresh(target, config.get_include_dirs(target), true);
+        for (auto& [platform, plat_config] : target.platform_configs) {
+            refresh(plat_config, config.get_include_dirs(target, &platform), true);
+        }
+    }
+    for (auto& [platform, plat_config] : config.global_platform_configs) {
+        refresh(plat_config, global_include_dirs(config, plat_config), false);
+    }
+
+    if (changed && !config_file_.empty()) {
+        ConfigSnapshot::save(config_file_, config_content_, config, config_files_, scanned_dirs_);
+    }
+    return changed;
+}
+
+std::vector<std::string> ConfigParser::get_source_dirs() {
+    std::set<std::string> existing;
+    for (const auto& entry : scanned_dirs_) {
+        const std::string& dir = entry.first;
+        if (FileSystemUtils::directory_exists(dir)) {
+            existing.insert(std::filesystem::path(dir).lexically_normal().generic_string());
+        }
+    }
+
+    std::vector<std::string> dirs;
+    for (const std::string& dir : existing) {
+        // Directories below another listed directory are already covered by it
+        bool nested = false;
+        std::filesystem::path path(dir);
+        while (!nested && path.has_relative_path() && path.has_parent_path()) {
+            path = path.parent_path();
+            nested = existing.count(path.generic_string()) != 0;
+        }
+        if (!nested) {
+            dirs.push_back(dir);
+        }
+    }
+    return dirs;
+}
+
+void ConfigParser::parse_content(const std::string& content, ProjectConfig& config) {
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        process_config_line(line, config);
+    }
+}
+
+std::string ConfigParser::read_file(const std::string& filename) {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return "";
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
 void ConfigParser::process_config_line(const std::string& line, ProjectConfig& config) {
     // Ignore comments (#) and empty lines
     if (line.empty() || line[0] == '#') {
@@ -56,6 +315,20 @@ void ConfigParser::process_config_line(const std::string& line, ProjectConfig& c
         return;
     }
     
+    // Check for generator rule configuration [rule.name.property]; keys of a target named
+    // "rule" have no second dot, e.g. rule.sources
+    if (key.find("rule.") == 0 && key.find('.', 5) != std::string::npos) {
+        process_rule_config_line(key, value_str, config);
+        return;
+    }
+
+    // Check for daemon configuration [daemon.test] or [daemon.test.target]; other keys such as
+    // daemon.sources belong to a target named "daemon"
+    if (key == "daemon.test" || key.find("daemon.test.") == 0) {
+        process_daemon_config_line(key, value_str, config);
+        return;
+    }
+    
     // Check for target-specific configuration [target.property]
     if (key.find('.') != std::string::npos) {
         process_target_config_line(key, value_str, config);
@@ -88,8 +361,7 @@ void ConfigParser::process_config_line(const std::string& line, ProjectConfig& c
     } else if (key == "cxx_flags") {
         config.cxx_flags = StringUtils::split(value_str, ',');
     } else if (key == "sources") {
-        std::vector<std::string> raw_sources = StringUtils::split(value_str, ',');
-        config.sources = expand_sources(raw_sources);
+        config.source_patterns = StringUtils::split(value_str, ',');
     } else if (key == "include_dirs") {
         config.include_dirs = StringUtils::split(value_str, ',');
     } else if (key == "library_dirs") {
@@ -127,8 +399,7 @@ void ConfigParser::process_target_config_line(const std::string& key, const std:
     } else if (property == "output_name") {
         target.output_name = value;
     } else if (property == "sources") {
-        std::vector<std::string> raw_sources = StringUtils::split(value, ',');
-        target.sources = expand_sources(raw_sources);
+        target.source_patterns = StringUtils::split(value, ',');
     } else if (property == "cxx_flags") {
         target.cxx_flags = StringUtils::split(value, ',');
     } else if (property == "include_dirs") {
@@ -192,6 +463,42 @@ void ConfigParser::process_sequence_config_line(const std::string& key, const st
     }
 }
 
+void ConfigParser::process_rule_config_line(const std::string& key, const std::string& value, ProjectConfig& config) {
+    size_t dot_pos = key.rfind('.');
+    if (dot_pos <= 5) {
+        return; // Missing rule name or property
+    }
+    std::string rule_name = key.substr(5, dot_pos - 5); // Remove "rule."
+    std::string property = key.substr(dot_pos + 1);
+
+    GeneratorRule& rule = config.rules[rule_name];
+    rule.name = rule_name;
+
+    if (property == "command") {
+        rule.command = value;
+    } else if (property == "inputs") {
+        rule.input_patterns = StringUtils::split(value, ',');
+    } else if (property == "outputs") {
+        rule.outputs = StringUtils::split(value, ',');
+        for (std::string& output : rule.outputs) {
+            output = FileSystemUtils::normalize_path(output);
+        }
+    } else if (property == "depfile") {
+        rule.depfile = value;
+    }
+}
+
+void ConfigParser::process_daemon_config_line(const std::string& key, const std::string& value, ProjectConfig& config) {
+    if (key == "daemon.test") {
+        // Test targets whose executable is run
+        for (const std::string& target : StringUtils::split(value, ',')) {
+            config.daemon_tests.emplace(target, "");
+        }
+    } else if (key.find("daemon.test.") == 0 && key.size() > 12) {
+        config.daemon_tests[key.substr(12)] = value; // Remove "daemon.test."
+    }
+}
+
 BuildType ConfigParser::parse_build_type(const std::string& type_str) {
     if (type_str == "exe" || type_str == "executable") {
         return BuildType::EXECUTABLE;
@@ -252,8 +559,7 @@ void ConfigParser::apply_platform_property(PlatformConfig& plat_config, const st
     if (property == "cxx_flags") {
         plat_config.cxx_flags = StringUtils::split(value, ',');
     } else if (property == "sources") {
-        std::vector<std::string> raw_sources = StringUtils::split(value, ',');
-        plat_config.sources = expand_sources(raw_sources);
+        plat_config.source_patterns = StringUtils::split(value, ',');
     } else if (property == "include_dirs") {
         plat_config.include_dirs = StringUtils::split(value, ',');
     } else if (property == "library_dirs") {
@@ -265,6 +571,234 @@ void ConfigParser::apply_platform_property(PlatformConfig& plat_config, const st
     }
 }
 
-std::vector<std::string> ConfigParser::expand_sources(const std::vector<std::string>& sources) {
-    return FileSystemUtils::expand_source_patterns(sources);
-}
\ No newline at end of file
+bool ConfigParser::expand_sources(const std::vector<std::string>& patterns, std::vector<std::string>& sources,
+                                  bool& resolved, const std::vector<std::string>& include_dirs) {
+    if (resolved) {
+        return false;
+    }
+
+    sources = FileSystemUtils::expand_source_patterns(patterns, include_dirs, &scanned_dirs_);
+    resolved = true;
+    return true;
+}
+
+bool ConfigParser::resolve_target_sources(ProjectConfig& config, BuildTarget& target,
+                                          const std::vector<Platform>& platforms) {
+    auto is_selected = [&](const Platform& platform) {
+        if (platforms.empty()) {
+            return true;
+        }
+        for (const Platform& selected : platforms) {
+            if (platform.matches(selected)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Sources shared by all platforms are only ordered by the include directories of all platforms
+    bool changed = false;
+    if (expand_sources(target.source_patterns, target.sources, target.sources_resolved, config.get_include_dirs(target))) {
+        add_generated_sources(config, target.source_patterns, target.sources);
+        changed = true;
+    }
+
+    for (auto& [platform, plat_config] : target.platform_configs) {
+        if (is_selected(platform) && expand_sources(plat_config.source_patterns, plat_config.sources,
+                                                    plat_config.sources_resolved,
+                                                    config.get_include_dirs(target, &platform))) {
+            add_generated_sources(config, plat_config.source_patterns, plat_config.sources);
+            changed = true;
+        }
+    }
+
+    // Global platform-specific sources are compiled into every target built for that platform
+    for (auto& [platform, plat_config] : config.global_platform_configs) {
+        if (is_selected(platform)) {
+            changed |= expand_sources(plat_config.source_patterns, plat_config.sources,
+                                      plat_config.sources_resolved, global_include_dirs(config, plat_config));
+        }
+    }
+
+    return changed;
+}
+
+void ConfigParser::add_generated_sources(const ProjectConfig& config, const std::vector<std::string>& patterns,
+                                         std::vector<std::string>& sources) {
+    for (const auto& [name, rule] : config.rules) {
+        for (const std::string& output : rule.outputs) {
+            // Generated headers are listed only to make the target depend on the rule
+            if (!FileSystemUtils::is_cpp_source_file(output)) {
+                sources.erase(std::remove(sources.begin(), sources.end(), output), sources.end());
+                continue;
+            }
+            if (std::find(sources.begin(), sources.end(), output) != sources.end()) {
+                continue;
+            }
+            for (const std::string& pattern : patterns) {
+                if (FileSystemUtils::pattern_covers(pattern, output)) {
+                    sources.push_back(output);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool ConfigParser::resolve_target_rules(ProjectConfig& config, const BuildTarget& target) {
+    std::vector<std::string> pending = config.get_target_rules(target);
+    bool changed = false;
+
+    while (!pending.empty()) {
+        GeneratorRule& rule = config.rules.at(pending.back());
+        pending.pop_back();
+        if (rule.inputs_resolved) {
+            continue;
+        }
+
+        rule.inputs = FileSystemUtils::expand_file_patterns(rule.input_patterns, &scanned_dirs_);
+        rule.inputs_resolved = true;
+        changed = true;
+
+        std::vector<std::string> dependencies = config.get_rule_dependencies(rule);
+        pending.insert(pending.end(), dependencies.begin(), dependencies.end());
+    }
+
+    return changed;
+}
+
+void ConfigParser::resolve_sources(ProjectConfig& config, const std::vector<std::string>& target_names,
+                                   const std::vector<Platform>& platforms) {
+    // Walk the selected targets and everything they link against
+    std::vector<std::string> pending = target_names;
+    std::set<std::string> visited;
+    bool changed = false;
+
+    while (!pending.empty()) {
+        std::string name = pending.back();
+        pending.pop_back();
+
+        auto it = config.targets.find(name);
+        if (it == config.targets.end() || !visited.insert(name).second) {
+            continue;
+        }
+
+        changed |= resolve_target_sources(config, it->second, platforms);
+        changed |= resolve_target_rules(config, it->second);
+
+        std::vector<std::string> dependencies = config.get_target_dependencies(it->second);
+        pending.insert(pending.end(), dependencies.begin(), dependencies.end());
+    }
+
+    if (changed && !config_file_.empty()) {
+        ConfigSnapshot::save(config_file_, config_content_, config, config_files_, scanned_dirs_);
+    }
+}
+
+void ConfigParser::resolve_all_sources(ProjectConfig& config, const std::vector<Platform>& platforms) {
+    std::vector<std::string> target_names;
+    for (const auto& [name, target] : config.targets) {
+        target_names.push_back(name);
+    }
+    resolve_sources(config, target_names, platforms);
+}
+
+void ConfigParser::load_dependency_projects(ProjectConfig& config) {
+    if (config.run_bodge_after_clone != "true") {
+        return;
+    }
+
+    for (const std::string& path : config.dependencies_path) {
+        std::string sub_file = path + "/.bodge";
+
+        // Recorded even if missing, so that a later clone invalidates the snapshot
+        config_files_[sub_file] = FileSystemUtils::get_modification_time(sub_file);
+
+        if (!FileSystemUtils::file_exists(sub_file)) {
+            continue;
+        }
+
+        ProjectConfig sub;
+        parse_content(read_file(sub_file), sub);
+        sub.apply_defaults();
+
+        merge_subproject(config, sub, path);
+    }
+}
+
+void ConfigParser::merge_subproject(ProjectConfig& config, const ProjectConfig& sub, const std::string& path) {
+    for (const auto& [name, sub_target] : sub.targets) {
+        BuildTarget target = sub_target;
+        target.name = path + ":" + name;
+        target.base_dir = path;
+
+        // The sub-project's globals only apply to its own targets
+        target.cxx_flags.insert(target.cxx_flags.begin(), sub.global_cxx_flags.begin(), sub.global_cxx_flags.end());
+        target.include_dirs.insert(target.include_dirs.end(), sub.global_include_dirs.begin(), sub.global_include_dirs.end());
+        target.library_dirs.insert(target.library_dirs.end(), sub.global_library_dirs.begin(), sub.global_library_dirs.end());
+        target.libraries.insert(target.libraries.end(), sub.global_libraries.begin(), sub.global_libraries.end());
+
+        for (const auto& [platform, global_config] : sub.global_platform_configs) {
+            PlatformConfig& plat_config = target.platform_configs[platform];
+            plat_config.target_platform = platform;
+            plat_config.cxx_flags.insert(plat_config.cxx_flags.end(), global_config.cxx_flags.begin(), global_config.cxx_flags.end());
+            plat_config.source_patterns.insert(plat_config.source_patterns.end(), global_config.source_patterns.begin(), global_config.source_patterns.end());
+            plat_config.include_dirs.insert(plat_config.include_dirs.end(), global_config.include_dirs.begin(), global_config.include_dirs.end());
+            plat_config.library_dirs.insert(plat_config.library_dirs.end(), global_config.library_dirs.begin(), global_config.library_dirs.end());
+            plat_config.libraries.insert(plat_config.libraries.end(), global_config.libraries.begin(), global_config.libraries.end());
+        }
+
+        if (target.target_platforms.empty()) {
+            target.target_platforms = sub.default_target_platforms;
+        }
+
+        prefix_paths(path, target.source_patterns);
+        prefix_paths(path, target.include_dirs);
+        prefix_paths(path, target.library_dirs);
+        for (auto& [platform, plat_config] : target.platform_configs) {
+            prefix_platform_config(path, plat_config);
+        }
+
+        // References to sibling targets by name become namespaced target references
+        auto namespace_libraries = [&](std::vector<std::string>& libraries) {
+            for (std::string& library : libraries) {
+                if (sub.targets.count(library) > 0) {
+                    library = path + ":" + library;
+                }
+            }
+        };
+        namespace_libraries(target.libraries);
+        for (auto& [platform, plat_config] : target.platform_configs) {
+            namespace_libraries(plat_config.libraries);
+        }
+
+        config.targets[target.name] = target;
+    }
+
+    for (const auto& [name, sub_sequence] : sub.sequences) {
+        Sequence sequence;
+        sequence.name = path + ":" + name;
+        for (Operation operation : sub_sequence.operations) {
+            if (operation.type == OperationType::BUILD) {
+                operation.target = path + ":" + operation.target;
+            } else {
+                operation.target = prefix_path(path, operation.target);
+                operation.destination = prefix_path(path, operation.destination);
+            }
+            sequence.operations.push_back(operation);
+        }
+        config.sequences[sequence.name] = sequence;
+    }
+
+    // Rule commands still run from the main project directory, $in and $out expand to prefixed paths
+    for (const auto& [name, sub_rule] : sub.rules) {
+        GeneratorRule rule = sub_rule;
+        rule.name = path + ":" + name;
+        prefix_paths(path, rule.input_patterns);
+        prefix_paths(path, rule.outputs);
+        if (!rule.depfile.empty()) {
+            rule.depfile = prefix_path(path, rule.depfile);
+        }
+        config.rules[rule.name] = rule;
+    }
+}
@@ -4,6 +4,7 @@
 #define CONFIG_PARSER_H
 
 #include "ProjectConfig.h"
+#include "FileSystemUtils.h"
 #include <string>
 
 /**
@@ -18,7 +19,95 @@ public:
      */
     static ProjectConfig load_project_config(const std::string& filename);
 
+    /**
+     * @brief Loads every project below the current directory into one configuration
+     *
+     * A .bodge file in the current directory is the main project. Every other directory
+     * containing a .bodge file (hidden directories are skipped) is merged as a sub-project
+     * with namespaced targets, e.g. "libs/core:core". Targets can reference targets of
+     * other projects by their namespaced name in their libraries.
+     * @return The combined configuration
+     */
+    static ProjectConfig load_workspace();
+
+    /**
+     * @brief Gets the directories of the projects merged by the last load_workspace()
+     * @return Project directories below the current one, in path order
+     */
+    static const std::vector<std::string>& get_workspace_projects();
+
+    /**
+     * @brief Expands the source patterns of the given targets and the targets they link against
+     *
+     * Expansion is memoized per target and platform block, so targets that are never
+     * built are never globbed or dependency-sorted. Newly expanded sources are added
+     * to the configuration snapshot.
+     * @param config Configuration returned by load_project_config
+     * @param target_names Targets that are about to be built
+     * @param platforms Platforms the targets are built for (empty for all platform blocks)
+     */
+    static void resolve_sources(ProjectConfig& config, const std::vector<std::string>& target_names,
+                                const std::vector<Platform>& platforms = {});
+
+    /**
+     * @brief Expands the source patterns of every target
+     * @param config Configuration returned by load_project_config
+     * @param platforms Platforms the targets are built for (empty for all platform blocks)
+     */
+    static void resolve_all_sources(ProjectConfig& config, const std::vector<Platform>& platforms = {});
+
+    /**
+     * @brief Gets the configuration files the last loaded configuration was read from
+     * @return The .bodge file followed by the .bodge files of merged sub-projects
+     */
+    static std::vector<std::string> get_config_files();
+
+    /**
+     * @brief Expands source lists again after files were created or deleted
+     *
+     * Only the lists whose patterns cover a created file, or that contain a deleted one,
+     * are expanded again; all other sources are kept.
+     * @param config Configuration with resolved sources
+     * @param changed_files Paths of files that changed
+     * @return true if any source list changed
+     */
+    static bool refresh_sources(ProjectConfig& config, const std::vector<std::string>& changed_files);
+
+    /**
+     * @brief Checks if refresh_sources() would change any source list
+     * @param config Configuration with resolved sources
+     * @param changed_files Paths of files that changed
+     * @return true if files matching a source pattern were created or listed files deleted
+     */
+    static bool sources_outdated(const ProjectConfig& config, const std::vector<std::string>& changed_files);
+
+    /**
+     * @brief Gets the directories source patterns were expanded from
+     * @return Directories listed while resolving sources, without those below another listed directory
+     */
+    static std::vector<std::string> get_source_dirs();
+
 private:
+    static std::string config_file_;   // Configuration file (or workspace key) of the snapshot
+    static std::string config_content_;
+    static DirectoryStamps config_files_;  // .bodge files of sub-projects the configuration depends on
+    static DirectoryStamps scanned_dirs_;  // Directories the expanded sources depend on
+    static std::vector<std::string> workspace_projects_;  // Project directories of the workspace
+
+    /**
+     * @brief Parses configuration file content line by line
+     * @param content Content of a .bodge file
+     * @param config Reference to the configuration object to populate
+     */
+    static void parse_content(const std::string& content, ProjectConfig& config);
+
+    /**
+     * @brief Reads a whole file
+     * @param filename Path of the file
+     * @return Content of the file, or an empty string if it cannot be read
+     */
+    static std::string read_file(const std::string& filename);
+
     /**
      * @brief Processes a single line from the configuration file
      * @param line The line to process
@@ -41,6 +130,22 @@ private:
      * @param config Reference to the configuration object to populate
      */
     static void process_sequence_config_line(const std::string& key, const std::string& value, ProjectConfig& config);
+
+    /**
+     * @brief Processes generator rule configuration lines
+     * @param key The configuration key (e.g., "rule.protos.command")
+     * @param value The configuration value
+     * @param config Reference to the configuration object to populate
+     */
+    static void process_rule_config_line(const std::string& key, const std::string& value, ProjectConfig& config);
+
+    /**
+     * @brief Processes daemon configuration lines
+     * @param key The configuration key (e.g., "daemon.test" or "daemon.test.mylib")
+     * @param value The configuration value
+     * @param config Reference to the configuration object to populate
+     */
+    static void process_daemon_config_line(const std::string& key, const std::string& value, ProjectConfig& config);
     
     /**
      * @brief Processes platform-specific configuration lines
@@ -66,11 +171,63 @@ private:
     static BuildType parse_build_type(const std::string& type_str);
     
     /**
-     * @brief Expands source patterns to actual file paths
-     * @param sources Vector of source patterns/files
-     * @return Vector of expanded source file paths
+     * @brief Expands a list of source patterns unless it was already expanded
+     * @param patterns Source patterns/files as written in the configuration
+     * @param sources Receives the expanded source file paths
+     * @param resolved Memo flag of the list, set after expansion
+     * @param include_dirs Include directories used to order the sources by their includes
+     * @return true if the list was expanded by this call
+     */
+    static bool expand_sources(const std::vector<std::string>& patterns, std::vector<std::string>& sources,
+                               bool& resolved, const std::vector<std::string>& include_dirs);
+
+    /**
+     * @brief Expands the sources a target needs for the given platforms
+     * @param config Reference to the configuration object
+     * @param target Target to expand
+     * @param platforms Selected platforms (empty for all platform blocks)
+     * @return true if any list was expanded by this call
+     */
+    static bool resolve_target_sources(ProjectConfig& config, BuildTarget& target,
+                                       const std::vector<Platform>& platforms);
+
+    /**
+     * @brief Adds the source files generated by rules that a list of patterns covers
+     *
+     * Generated files usually do not exist yet when the patterns are expanded. Generated
+     * files that are not C/C++ sources (e.g. headers) are removed from the list instead.
+     * @param config The configuration holding the rules
+     * @param patterns Source patterns of the list
+     * @param sources Expanded list to complete
+     */
+    static void add_generated_sources(const ProjectConfig& config, const std::vector<std::string>& patterns,
+                                      std::vector<std::string>& sources);
+
+    /**
+     * @brief Expands the inputs of the rules a target uses and of the rules those depend on
+     * @param config Reference to the configuration object
+     * @param target Target whose rules are expanded
+     * @return true if any rule was expanded by this call
+     */
+    static bool resolve_target_rules(ProjectConfig& config, const BuildTarget& target);
+
+    /**
+     * @brief Loads the .bodge files of git dependencies as namespaced sub-projects
+     *
+     * Only done when run_bodge_after_clone is "true". Targets and sequences of the
+     * dependency at "dep/zlib" are added as "dep/zlib:<name>", with their paths made
+     * relative to the main project, so that everything is built in one plan.
+     * @param config Reference to the configuration object to extend
+     */
+    static void load_dependency_projects(ProjectConfig& config);
+
+    /**
+     * @brief Merges the targets and sequences of a sub-project into the configuration
+     * @param config Reference to the configuration object to extend
+     * @param sub The parsed sub-project
+     * @param path Directory of the sub-project, used as namespace and path prefix
      */
-    static std::vector<std::string> expand_sources(const std::vector<std::string>& sources);
+    static void merge_subproject(ProjectConfig& config, const ProjectConfig& sub, const std::string& path);
 };
 
 #endif // CONFIG_PARSER_H
\ No newline at end of file
@@ -0,0 +1,542 @@
+#include "ConfigSnapshot.h"
+#include "core.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'B', 'O', 'D', 'G', 'E', 'S', 'N', 'P'};
+    const uint32_t SNAPSHOT_VERSION = 5;
+
+    // Snapshot of one configuration; the project and a workspace in the same directory keep their own
+    std::string snapshot_file(const std::string& filename) {
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(ConfigSnapshot::hash_content(filename)));
+        return std::string(BODGE_CACHE_DIR) + "/config-" + hash + ".snapshot";
+    }
+
+    // Name of a temporary file no other bodge process or thread writes to at the same time
+    std::string unique_temp_file(const std::string& file) {
+        static std::atomic<unsigned> counter(0);
+#ifdef _WIN32
+        int pid = _getpid();
+#else
+        int pid = static_cast<int>(getpid());
+#endif
+        return file + "." + std::to_string(pid) + "." + std::to_string(++counter) + ".tmp";
+    }
+
+    /**
+     * Read-only view of the snapshot file, memory-mapped where the platform allows it
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+#ifndef _WIN32
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                return;
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED) {
+                    data_ = static_cast<const char*>(mapped);
+                    size_ = static_cast<size_t>(st.st_size);
+                }
+            }
+            ::close(fd);
+#else
+            std::ifstream input(path, std::ios::in | std::ios::binary);
+            if (input.is_open()) {
+                buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+                data_ = buffer_.data();
+                size_ = buffer_.size();
+            }
+#endif
+        }
+
+        ~MappedFile() {
+#ifndef _WIN32
+            if (data_ != nullptr) {
+                munmap(const_cast<char*>(data_), size_);
+            }
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        const char* data_;
+        size_t size_;
+#ifdef _WIN32
+        std::string buffer_;
+#endif
+    };
+
+    /**
+     * Appends little-endian binary fields to a buffer
+     */
+    class SnapshotWriter {
+    public:
+        void u8(uint8_t value) { data_.push_back(static_cast<char>(value)); }
+
+        void u32(uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                u8(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        void u64(uint64_t value) {
+            for (int i = 0; i < 8; ++i) {
+                u8(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        void str(const std::string& value) {
+            u32(static_cast<uint32_t>(value.size()));
+            data_.append(value);
+        }
+
+        void strings(const std::vector<std::string>& values) {
+            u32(static_cast<uint32_t>(values.size()));
+            for (const std::string& value : values) {
+                str(value);
+            }
+        }
+
+        void platform(const Platform& value) {
+            u8(static_cast<uint8_t>(value.operating_system));
+            u8(static_cast<uint8_t>(value.architecture));
+        }
+
+        void platforms(const std::vector<Platform>& values) {
+            u32(static_cast<uint32_t>(values.size()));
+            for (const Platform& value : values) {
+                platform(value);
+            }
+        }
+
+        void platform_config(const PlatformConfig& value) {
+            platform(value.target_platform);
+            strings(value.cxx_flags);
+            strings(value.sources);
+            strings(value.source_patterns);
+            strings(value.include_dirs);
+            strings(value.library_dirs);
+            strings(value.libraries);
+            str(value.output_name_suffix);
+            u8(value.sources_resolved ? 1 : 0);
+        }
+
+        void platform_configs(const std::map<Platform, PlatformConfig>& values) {
+            u32(static_cast<uint32_t>(values.size()));
+            for (const auto& [key, value] : values) {
+                platform(key);
+                platform_config(value);
+            }
+        }
+
+        const std::string& data() const { return data_; }
+
+    private:
+        std::string data_;
+    };
+
+    /**
+     * Reads fields written by SnapshotWriter; any out-of-bounds read marks the reader as failed
+     */
+    class SnapshotReader {
+    public:
+        SnapshotReader(const char* data, size_t size) : data_(data), size_(size), pos_(0), ok_(true) {}
+
+        bool ok() const { return ok_; }
+
+        bool bytes(void* out, size_t count) {
+            if (!ok_ || size_ - pos_ < count) {
+                ok_ = false;
+                return false;
+            }
+            std::memcpy(out, data_ + pos_, count);
+            pos_ += count;
+            return true;
+        }
+
+        uint8_t u8() {
+            uint8_t value = 0;
+            bytes(&value, 1);
+            return value;
+        }
+
+        uint32_t u32() {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value |= static_cast<uint32_t>(u8()) << (i * 8);
+            }
+            return value;
+        }
+
+        uint64_t u64() {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value |= static_cast<uint64_t>(u8()) << (i * 8);
+            }
+            return value;
+        }
+
+        std::string str() {
+            uint32_t length = u32();
+            if (!ok_ || size_ - pos_ < length) {
+                ok_ = false;
+                return "";
+            }
+            std::string value(data_ + pos_, length);
+            pos_ += length;
+            return value;
+        }
+
+        std::vector<std::string> strings() {
+            uint32_t count = u32();
+            std::vector<std::string> values;
+            for (uint32_t i = 0; i < count && ok_; ++i) {
+                values.push_back(str());
+            }
+            return values;
+        }
+
+        Platform platform() {
+            Platform value;
+            value.operating_system = static_cast<OS>(u8());
+            value.architecture = static_cast<Architecture>(u8());
+            return value;
+        }
+
+        std::vector<Platform> platforms() {
+            uint32_t count = u32();
+            std::vector<Platform> values;
+            for (uint32_t i = 0; i < count && ok_; ++i) {
+                values.push_back(platform());
+            }
+            return values;
+        }
+
+        PlatformConfig platform_config() {
+            PlatformConfig value;
+            value.target_platform = platform();
+            value.cxx_flags = strings();
+            value.sources = strings();
+            value.source_patterns = strings();
+            value.include_dirs = strings();
+            value.library_dirs = strings();
+            value.libraries = strings();
+            value.output_name_suffix = str();
+            value.sources_resolved = u8() != 0;
+            return value;
+        }
+
+        std::map<Platform, PlatformConfig> platform_configs() {
+            uint32_t count = u32();
+            std::map<Platform, PlatformConfig> values;
+            for (uint32_t i = 0; i < count && ok_; ++i) {
+                Platform key = platform();
+                values[key] = platform_config();
+            }
+            return values;
+        }
+
+    private:
+        const char* data_;
+        size_t size_;
+        size_t pos_;
+        bool ok_;
+    };
+
+    void write_config(SnapshotWriter& out, const ProjectConfig& config) {
+        out.str(config.name);
+        out.str(config.compiler);
+        out.strings(config.global_cxx_flags);
+        out.strings(config.global_include_dirs);
+        out.strings(config.global_library_dirs);
+        out.strings(config.global_libraries);
+        out.strings(config.dependencies_url);
+        out.strings(config.dependencies_path);
+        out.str(config.run_bodge_after_clone);
+
+        out.u32(static_cast<uint32_t>(config.targets.size()));
+        for (const auto& [name, target] : config.targets) {
+            out.str(name);
+            out.str(target.name);
+            out.u8(static_cast<uint8_t>(target.type));
+            out.str(target.output_name);
+            out.strings(target.cxx_flags);
+            out.strings(target.sources);
+            out.strings(target.source_patterns);
+            out.strings(target.include_dirs);
+            out.strings(target.library_dirs);
+            out.strings(target.libraries);
+            out.u8(target.sources_resolved ? 1 : 0);
+            out.str(target.base_dir);
+            out.platform_configs(target.platform_configs);
+            out.platforms(target.target_platforms);
+        }
+
+        out.u32(static_cast<uint32_t>(config.sequences.size()));
+        for (const auto& [name, sequence] : config.sequences) {
+            out.str(name);
+            out.str(sequence.name);
+            out.u32(static_cast<uint32_t>(sequence.operations.size()));
+            for (const Operation& operation : sequence.operations) {
+                out.u8(static_cast<uint8_t>(operation.type));
+                out.str(operation.target);
+                out.str(operation.destination);
+            }
+        }
+
+        out.u32(static_cast<uint32_t>(config.rules.size()));
+        for (const auto& [name, rule] : config.rules) {
+            out.str(name);
+            out.str(rule.name);
+            out.str(rule.command);
+            out.strings(rule.input_patterns);
+            out.strings(rule.inputs);
+            out.strings(rule.outputs);
+            out.str(rule.depfile);
+            out.u8(rule.inputs_resolved ? 1 : 0);
+        }
+
+        out.u32(static_cast<uint32_t>(config.daemon_tests.size()));
+        for (const auto& [target, command] : config.daemon_tests) {
+            out.str(target);
+            out.str(command);
+        }
+
+        out.platform_configs(config.global_platform_configs);
+        out.platforms(config.default_target_platforms);
+
+        out.str(config.output_name);
+        out.strings(config.cxx_flags);
+        out.strings(config.sources);
+        out.strings(config.source_patterns);
+        out.strings(config.include_dirs);
+        out.strings(config.library_dirs);
+        out.strings(config.libraries);
+    }
+
+    void read_config(SnapshotReader& in, ProjectConfig& config) {
+        config.name = in.str();
+        config.compiler = in.str();
+        config.global_cxx_flags = in.strings();
+        config.global_include_dirs = in.strings();
+        config.global_library_dirs = in.strings();
+        config.global_libraries = in.strings();
+        config.dependencies_url = in.strings();
+        config.dependencies_path = in.strings();
+        config.run_bodge_after_clone = in.str();
+
+        uint32_t target_count = in.u32();
+        for (uint32_t i = 0; i < target_count && in.ok(); ++i) {
+            BuildTarget& target = config.targets[in.str()];
+            target.name = in.str();
+            target.type = static_cast<BuildType>(in.u8());
+            target.output_name = in.str();
+            target.cxx_flags = in.strings();
+            target.sources = in.strings();
+            target.source_patterns = in.strings();
+            target.include_dirs = in.strings();
+            target.library_dirs = in.strings();
+            target.libraries = in.strings();
+            target.sources_resolved = in.u8() != 0;
+            target.base_dir = in.str();
+            target.platform_configs = in.platform_configs();
+            target.target_platforms = in.platforms();
+        }
+
+        uint32_t sequence_count = in.u32();
+        for (uint32_t i = 0; i < sequence_count && in.ok(); ++i) {
+            Sequence& sequence = config.sequences[in.str()];
+            sequence.name = in.str();
+            uint32_t operation_count = in.u32();
+            for (uint32_t j = 0; j < operation_count && in.ok(); ++j) {
+                Operation operation;
+                operation.type = static_cast<OperationType>(in.u8());
+                operation.target = in.str();
+                operation.destination = in.str();
+                sequence.operations.push_back(operation);
+            }
+        }
+
+        uint32_t rule_count = in.u32();
+        for (uint32_t i = 0; i < rule_count && in.ok(); ++i) {
+            GeneratorRule& rule = config.rules[in.str()];
+            rule.name = in.str();
+            rule.command = in.str();
+            rule.input_patterns = in.strings();
+            rule.inputs = in.strings();
+            rule.outputs = in.strings();
+            rule.depfile = in.str();
+            rule.inputs_resolved = in.u8() != 0;
+        }
+
+        uint32_t test_count = in.u32();
+        for (uint32_t i = 0; i < test_count && in.ok(); ++i) {
+            std::string target = in.str();
+            config.daemon_tests[target] = in.str();
+        }
+
+        config.global_platform_configs = in.platform_configs();
+        config.default_target_platforms = in.platforms();
+
+        config.output_name = in.str();
+        config.cxx_flags = in.strings();
+        config.sources = in.strings();
+        config.source_patterns = in.strings();
+        config.include_dirs = in.strings();
+        config.library_dirs = in.strings();
+        config.libraries = in.strings();
+    }
+}
+
+bool ConfigSnapshot::load(const std::string& filename, const std::string& content, ProjectConfig& config,
+                          DirectoryStamps& config_files, DirectoryStamps& scanned_dirs) {
+    MappedFile file(snapshot_file(filename));
+    if (file.data() == nullptr) {
+        return false;
+    }
+
+    SnapshotReader in(file.data(), file.size());
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!in.bytes(magic, sizeof(magic)) || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 ||
+        in.u32() != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    if (in.str() != filename || in.u64() != hash_content(content)) {
+        return false;
+    }
+
+    // Sub-project .bodge files that appeared, disappeared or changed require a full parse
+    DirectoryStamps files;
+    uint32_t file_count = in.u32();
+    for (uint32_t i = 0; i < file_count && in.ok(); ++i) {
+        std::string file = in.str();
+        long long mtime = static_cast<long long>(in.u64());
+        if (!in.ok() || FileSystemUtils::get_modification_time(file) != mtime) {
+            return false;
+        }
+        files[file] = mtime;
+    }
+
+    // Any directory that gained, lost or renamed an entry invalidates the expanded sources
+    DirectoryStamps dirs;
+    bool dirs_unchanged = true;
+    uint32_t dir_count = in.u32();
+    for (uint32_t i = 0; i < dir_count && in.ok(); ++i) {
+        std::string dir = in.str();
+        long long mtime = static_cast<long long>(in.u64());
+        dirs[dir] = mtime;
+        if (dirs_unchanged && FileSystemUtils::get_modification_time(dir) != mtime) {
+            dirs_unchanged = false;
+        }
+    }
+
+    ProjectConfig snapshot;
+    read_config(in, snapshot);
+    if (!in.ok()) {
+        return false;
+    }
+
+    // The parsed configuration is still valid, only the sources need to be expanded again
+    if (dirs_unchanged) {
+        scanned_dirs = std::move(dirs);
+    } else {
+        snapshot.clear_resolved_sources();
+        scanned_dirs.clear();
+    }
+
+    config_files = std::move(files);
+    config = std::move(snapshot);
+    return true;
+}
+
+bool ConfigSnapshot::save(const std::string& filename, const std::string& content, const ProjectConfig& config,
+                          const DirectoryStamps& config_files, const DirectoryStamps& scanned_dirs) {
+    SnapshotWriter out;
+    for (char c : SNAPSHOT_MAGIC) {
+        out.u8(static_cast<uint8_t>(c));
+    }
+    out.u32(SNAPSHOT_VERSION);
+    out.str(filename);
+    out.u64(hash_content(content));
+
+    out.u32(static_cast<uint32_t>(config_files.size()));
+    for (const auto& [file, mtime] : config_files) {
+        out.str(file);
+        out.u64(static_cast<uint64_t>(mtime));
+    }
+
+    out.u32(static_cast<uint32_t>(scanned_dirs.size()));
+    for (const auto& [dir, mtime] : scanned_dirs) {
+        out.str(dir);
+        out.u64(static_cast<uint64_t>(mtime));
+    }
+
+    write_config(out, config);
+
+    try {
+        std::filesystem::create_directories(BODGE_CACHE_DIR);
+
+        // Write to a temporary file and rename so readers never see a partial snapshot. Every
+        // writer uses a file of its own, so concurrent bodge processes cannot mix their snapshots
+        std::string snapshot = snapshot_file(filename);
+        std::string temp_file = unique_temp_file(snapshot);
+        {
+            std::ofstream output(temp_file, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!output.is_open()) {
+                return false;
+            }
+            output.write(out.data().data(), static_cast<std::streamsize>(out.data().size()));
+            if (!output.good()) {
+                output.close();
+                std::filesystem::remove(temp_file);
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_file, snapshot, ec);
+        if (ec) {
+            std::filesystem::remove(temp_file);
+            throw std::filesystem::filesystem_error("rename", temp_file, snapshot, ec);
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "[WARNING] Could not write configuration snapshot: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t ConfigSnapshot::hash_content(const std::string& content) {
+    uint64_t value = 14695981039346656037ull;
+    for (char c : content) {
+        value ^= static_cast<unsigned char>(c);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include "ProjectConfig.h"
+#include "FileSystemUtils.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Binary snapshot of a parsed ProjectConfig
+ *
+ * Every configuration file (or workspace) has a snapshot file of its own in the bodge
+ * cache directory. A snapshot is keyed by a hash of the configuration file's content and
+ * the modification times of the .bodge files of merged sub-projects. It also records the modification times of every
+ * directory the already expanded source patterns were read from; while those still
+ * match, the expanded sources are reused as well, otherwise they are discarded and
+ * expanded again on demand.
+ */
+class ConfigSnapshot {
+public:
+    /**
+     * @brief Loads the snapshot if it is still valid for the given configuration file
+     * @param filename Path of the configuration file
+     * @param content Current content of the configuration file
+     * @param config Receives the parsed configuration on success
+     * @param config_files Receives the sub-project .bodge files the configuration depends on
+     * @param scanned_dirs Receives the directories the reused sources depend on
+     * @return true if the snapshot was valid and loaded
+     */
+    static bool load(const std::string& filename, const std::string& content, ProjectConfig& config,
+                     DirectoryStamps& config_files, DirectoryStamps& scanned_dirs);
+
+    /**
+     * @brief Writes a snapshot of a parsed configuration
+     * @param filename Path of the configuration file
+     * @param content Content the configuration was parsed from
+     * @param config The parsed configuration, including any expanded sources
+     * @param config_files Sub-project .bodge files the configuration depends on (-1 if missing)
+     * @param scanned_dirs Directories the source patterns were expanded from
+     * @return true if the snapshot was written
+     */
+    static bool save(const std::string& filename, const std::string& content, const ProjectConfig& config,
+                     const DirectoryStamps& config_files, const DirectoryStamps& scanned_dirs);
+
+    /**
+     * @brief Hashes configuration file content (64-bit FNV-1a)
+     * @param content Data to hash
+     * @return 64-bit hash value
+     */
+    static uint64_t hash_content(const std::string& content);
+};
+
+#endif // CONFIG_SNAPSHOT_H
@@ -0,0 +1,242 @@
+#include "ContentHash.h"
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace {
+    const uint64_t PRIME1 = 11400714785074694791ULL;
+    const uint64_t PRIME2 = 14029467366897019727ULL;
+    const uint64_t PRIME3 = 1609587929392839161ULL;
+    const uint64_t PRIME4 = 9650029242287828579ULL;
+    const uint64_t PRIME5 = 2870177450012600261ULL;
+
+    inline uint64_t rotl(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t read64(const unsigned char* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t read32(const unsigned char* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline bool is_word_char(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    inline uint64_t mix_round(uint64_t acc, uint64_t input) {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    inline uint64_t merge_round(uint64_t acc, uint64_t value) {
+        acc ^= mix_round(0, value);
+        return acc * PRIME1 + PRIME4;
+    }
+}
+
+uint64_t ContentHash::hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = mix_round(v1, read64(p));
+            v2 = mix_round(v2, read64(p + 8));
+            v3 = mix_round(v3, read64(p + 16));
+            v4 = mix_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    // Tail: 8, 4 and 1 byte steps
+    for (; p + 8 <= end; p += 8) {
+        h ^= mix_round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool ContentHash::hash_file(const std::string& path, uint64_t& hash) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::streamsize size = in.tellg();
+    if (size < 0) {
+        return false;
+    }
+    in.seekg(0);
+
+    std::vector<char> content(static_cast<size_t>(size));
+    if (size > 0 && !in.read(content.data(), size)) {
+        return false;
+    }
+    hash = ContentHash::hash(content.data(), content.size());
+    return true;
+}
+
+void ContentHash::hash_tokens(const std::string& content, uint64_t& tokens, uint64_t& lines) {
+    // Both streams get the same tokens; the line stream also gets every line end
+    std::string token_stream;
+    std::string line_stream;
+    token_stream.reserve(content.size());
+    line_stream.reserve(content.size());
+
+    bool separated = false;   // Whitespace or a comment since the last token character
+    bool line_start = true;   // Nothing but whitespace on the current line so far
+    bool directive = false;   // The current line is a preprocessor directive
+    bool number = false;      // The last token character belongs to a pp-number, like 1.e+5
+    // The current line is "#define NAME" so far; a "(" right after the name makes the macro function-like
+    auto defines_macro = [&]() {
+        size_t start = token_stream.rfind('\n');
+        start = start == std::string::npos ? 0 : start + 1;
+        if (!directive || token_stream.compare(start, 8, "#define ") != 0 || token_stream.size() == start + 8) {
+            return false;
+        }
+        return std::all_of(token_stream.begin() + static_cast<std::ptrdiff_t>(start + 8), token_stream.end(), is_word_char);
+    };
+    auto emit = [&](char c) {
+        char last = token_stream.empty() ? '\n' : token_stream.back();
+        // A pp-number goes on with word characters, dots and the sign of an exponent
+        bool continues_number = number && (is_word_char(c) || c == '.' ||
+                                           ((c == '+' || c == '-') && (last == 'e' || last == 'E' || last == 'p' || last == 'P')));
+        // Two word characters, or two punctuators like "+ +", must not be joined. Neither must a
+        // pp-number and what would extend it ("1.e + 5"), or a macro name and its "(" ("F (x)")
+        if (separated && last != '\n' &&
+            (is_word_char(last) == is_word_char(c) || continues_number || (c == '(' && defines_macro()))) {
+            token_stream += ' ';
+            line_stream += ' ';
+        }
+        number = separated ? std::isdigit(static_cast<unsigned char>(c)) != 0
+                           : continues_number || (std::isdigit(static_cast<unsigned char>(c)) && !is_word_char(last));
+        separated = false;
+        token_stream += c;
+        line_stream += c;
+    };
+    auto current_word = [&]() {
+        size_t start = token_stream.size();
+        while (!separated && start > 0 && is_word_char(token_stream[start - 1])) {
+            --start;
+        }
+        return token_stream.substr(start);
+    };
+
+    const size_t n = content.size();
+    size_t i = 0;
+    while (i < n) {
+        char c = content[i];
+        if (c == '\\' && i + 1 < n && (content[i + 1] == '\n' || (content[i + 1] == '\r' && i + 2 < n && content[i + 2] == '\n'))) {
+            // Line continuation: the lines are joined, but line numbers still advance
+            i += content[i + 1] == '\n' ? 2 : 3;
+            line_stream += '\n';
+        } else if (c == '\n') {
+            if (directive) {
+                token_stream += '\n';
+            }
+            line_stream += '\n';
+            directive = false;
+            line_start = true;
+            separated = true;
+            ++i;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            separated = true;
+            ++i;
+        } else if (c == '/' && i + 1 < n && content[i + 1] == '/') {
+            while (i < n && content[i] != '\n') {
+                if (content[i] == '\\' && i + 1 < n && content[i + 1] == '\n') {
+                    line_stream += '\n';
+                    ++i;
+                }
+                ++i;
+            }
+            separated = true;
+        } else if (c == '/' && i + 1 < n && content[i + 1] == '*') {
+            i += 2;
+            while (i < n && !(content[i] == '*' && i + 1 < n && content[i + 1] == '/')) {
+                if (content[i] == '\n') {
+                    line_stream += '\n';
+                }
+                ++i;
+            }
+            i = std::min(i + 2, n);
+            separated = true;
+        } else if ((c == '"' || c == '\'') && !(c == '\'' && !separated && !current_word().empty() &&
+                                               std::isdigit(static_cast<unsigned char>(current_word()[0])))) {
+            // String or character literal (a quote inside a number is a digit separator)
+            std::string prefix = c == '"' ? current_word() : "";
+            bool raw = prefix == "R" || prefix == "u8R" || prefix == "uR" || prefix == "UR" || prefix == "LR";
+            line_start = false;
+            emit(c);
+            size_t end;
+            if (raw) {
+                size_t open = content.find('(', i + 1);
+                std::string terminator = open == std::string::npos ? "" : ")" + content.substr(i + 1, open - i - 1) + "\"";
+                end = open == std::string::npos ? std::string::npos : content.find(terminator, open);
+                end = end == std::string::npos ? n : end + terminator.size();
+            } else {
+                end = i + 1;
+                while (end < n && content[end] != c && content[end] != '\n') {
+                    end += content[end] == '\\' && end + 1 < n ? 2 : 1;
+                }
+                end = std::min(end + 1, n);
+            }
+            for (size_t k = i + 1; k < end; ++k) {
+                token_stream += content[k];
+                line_stream += content[k];
+            }
+            i = end;
+        } else {
+            if (line_start && c == '#') {
+                directive = true;
+            }
+            line_start = false;
+            emit(c);
+            ++i;
+        }
+    }
+
+    tokens = hash(token_stream.data(), token_stream.size());
+    lines = hash(line_stream.data(), line_stream.size());
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Fast 64-bit fingerprint of file contents
+ *
+ * Implements the XXH64 algorithm: input is consumed in 32 byte stripes by four
+ * independent accumulators, which lets the compiler keep them in parallel registers
+ * and runs at memory speed. The hash is not cryptographic; it only tells whether a
+ * file's content changed.
+ */
+class ContentHash {
+public:
+    /**
+     * @brief Hashes a block of memory
+     * @param data Start of the data
+     * @param size Number of bytes
+     * @param seed Initial value
+     * @return 64-bit hash
+     */
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+    /**
+     * @brief Hashes the content of a file
+     * @param path File path
+     * @param hash Receives the hash
+     * @return true if the file could be read
+     */
+    static bool hash_file(const std::string& path, uint64_t& hash);
+
+    /**
+     * @brief Hashes the C/C++ token stream of a source text
+     *
+     * Comments and whitespace between tokens are ignored, except for the line ends of
+     * preprocessor directives and spaces that keep two tokens apart: between two words or two
+     * punctuators, after a pp-number like 1.e that a sign would extend, and between the name of
+     * a #define and a "(" that would make the macro function-like. Literals are hashed
+     * verbatim. Edits that only touch comments or formatting keep the token hash; the line
+     * hash additionally changes when a token moves to another line, which affects __LINE__
+     * and the line numbers in debug information.
+     * @param content Source text
+     * @param tokens Receives the hash of the token stream
+     * @param lines Receives the hash of the token stream with the line of every token
+     */
+    static void hash_tokens(const std::string& content, uint64_t& tokens, uint64_t& lines);
+};
+
+#endif // CONTENT_HASH_H
@@ -0,0 +1,202 @@
+#include "DaemonMetrics.h"
+#include "IncludeGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+    // Resident set size of this process in bytes, or -1 where it cannot be determined
+    long long resident_memory_bytes() {
+#ifdef __linux__
+        std::ifstream statm("/proc/self/statm");
+        long long total_pages = 0;
+        long long resident_pages = 0;
+        if (statm >> total_pages >> resident_pages) {
+            return resident_pages * sysconf(_SC_PAGESIZE);
+        }
+#endif
+        return -1;
+    }
+
+    const char* result_label(E_RESULT result) {
+        switch (result) {
+            case S_OK:
+                return "success";
+            case S_CANCELLED:
+                return "cancelled";
+            default:
+                return "failed";
+        }
+    }
+}
+
+DaemonMetrics::Histogram::Histogram(std::vector<double> upper_bounds)
+    : bounds(std::move(upper_bounds)), counts(bounds.size() + 1, 0) {}
+
+void DaemonMetrics::Histogram::observe(double value) {
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    ++counts[bucket];
+    sum += value;
+    ++count;
+}
+
+void DaemonMetrics::record_change_latency(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    change_latency_.observe(seconds);
+}
+
+void DaemonMetrics::record_build(E_RESULT result, double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++builds_[result_label(result)];
+    if (result != S_CANCELLED) {
+        build_duration_.observe(seconds);
+    }
+}
+
+void DaemonMetrics::record_action(const std::string& target, const std::string& platform, E_RESULT result,
+                                  double seconds) {
+    if (result == S_CANCELLED) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto key = std::make_pair(target, platform);
+    if (result != S_OK) {
+        ++action_failures_[key];
+        return;
+    }
+
+    ActionDurations& durations = durations_[key];
+    durations.recent.push_back(seconds);
+    if (durations.recent.size() > RECENT_DURATIONS) {
+        durations.recent.pop_front();
+    }
+    durations.sum += seconds;
+    ++durations.count;
+}
+
+void DaemonMetrics::record_cache_lookup(const std::string& cache, bool hit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++cache_lookups_[std::make_pair(cache, hit)];
+}
+
+void DaemonMetrics::set_watched_files(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    watched_files_ = count;
+}
+
+void DaemonMetrics::set_queue_depth(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_depth_ = count;
+}
+
+std::string DaemonMetrics::render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+
+    render_histogram(out, "bodge_change_to_build_start_seconds",
+                     "Time from detecting a file change to starting the rebuild it triggers", change_latency_);
+    render_histogram(out, "bodge_build_duration_seconds", "Duration of finished rebuilds", build_duration_);
+
+    out += "# HELP bodge_builds_total Rebuilds by result\n";
+    out += "# TYPE bodge_builds_total counter\n";
+    for (const char* result : {"success", "failed", "cancelled"}) {
+        auto it = builds_.find(result);
+        out += std::string("bodge_builds_total{result=\"") + result + "\"} " +
+               std::to_string(it == builds_.end() ? 0 : it->second) + "\n";
+    }
+
+    out += "# HELP bodge_action_duration_seconds Duration of successful target and rule builds, "
+           "quantiles over the last " + std::to_string(RECENT_DURATIONS) + " builds\n";
+    out += "# TYPE bodge_action_duration_seconds summary\n";
+    for (const auto& [key, durations] : durations_) {
+        std::string labels = "target=\"" + escape_label(key.first) + "\",platform=\"" + escape_label(key.second) + "\"";
+        std::vector<double> sorted(durations.recent.begin(), durations.recent.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (double quantile : {0.5, 0.95, 0.99}) {
+            size_t rank = static_cast<size_t>(std::ceil(quantile * sorted.size()));
+            double value = sorted[rank > 0 ? rank - 1 : 0];
+            out += "bodge_action_duration_seconds{" + labels + ",quantile=\"" + format_value(quantile) + "\"} " +
+                   format_value(value) + "\n";
+        }
+        out += "bodge_action_duration_seconds_sum{" + labels + "} " + format_value(durations.sum) + "\n";
+        out += "bodge_action_duration_seconds_count{" + labels + "} " + std::to_string(durations.count) + "\n";
+    }
+
+    out += "# HELP bodge_action_failures_total Failed target and rule builds\n";
+    out += "# TYPE bodge_action_failures_total counter\n";
+    for (const auto& [key, failures] : action_failures_) {
+        out += "bodge_action_failures_total{target=\"" + escape_label(key.first) + "\",platform=\"" +
+               escape_label(key.second) + "\"} " + std::to_string(failures) + "\n";
+    }
+
+    // Include scans are counted by IncludeGraph itself
+    std::map<std::pair<std::string, bool>, uint64_t> lookups = cache_lookups_;
+    uint64_t scan_hits = 0;
+    uint64_t scan_misses = 0;
+    IncludeGraph::get_scan_stats(scan_hits, scan_misses);
+    lookups[std::make_pair(std::string("include_scan"), true)] = scan_hits;
+    lookups[std::make_pair(std::string("include_scan"), false)] = scan_misses;
+    out += "# HELP bodge_cache_lookups_total Cache lookups by cache and result\n";
+    out += "# TYPE bodge_cache_lookups_total counter\n";
+    for (const auto& [key, count] : lookups) {
+        out += "bodge_cache_lookups_total{cache=\"" + escape_label(key.first) + "\",result=\"" +
+               (key.second ? "hit" : "miss") + "\"} " + std::to_string(count) + "\n";
+    }
+
+    out += "# HELP bodge_watched_files Files watched for changes\n";
+    out += "# TYPE bodge_watched_files gauge\n";
+    out += "bodge_watched_files " + std::to_string(watched_files_) + "\n";
+    out += "# HELP bodge_queue_depth Actions waiting to be built\n";
+    out += "# TYPE bodge_queue_depth gauge\n";
+    out += "bodge_queue_depth " + std::to_string(queue_depth_) + "\n";
+
+    long long resident = resident_memory_bytes();
+    if (resident >= 0) {
+        out += "# HELP process_resident_memory_bytes Resident memory size in bytes\n";
+        out += "# TYPE process_resident_memory_bytes gauge\n";
+        out += "process_resident_memory_bytes " + std::to_string(resident) + "\n";
+    }
+
+    return out;
+}
+
+std::string DaemonMetrics::escape_label(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string DaemonMetrics::format_value(double value) {
+    std::ostringstream out;
+    out << std::setprecision(9) << value;
+    return out.str();
+}
+
+void DaemonMetrics::render_histogram(std::string& out, const std::string& name, const std::string& help,
+                                     const Histogram& histogram) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < histogram.bounds.size(); ++i) {
+        cumulative += histogram.counts[i];
+        out += name + "_bucket{le=\"" + format_value(histogram.bounds[i]) + "\"} " + std::to_string(cumulative) + "\n";
+    }
+    out += name + "_bucket{le=\"+Inf\"} " + std::to_string(histogram.count) + "\n";
+    out += name + "_sum " + format_value(histogram.sum) + "\n";
+    out += name + "_count " + std::to_string(histogram.count) + "\n";
+}
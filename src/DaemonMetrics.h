@@ -0,0 +1,117 @@
+#pragma once
+
+#ifndef DAEMON_METRICS_H
+#define DAEMON_METRICS_H
+
+#include "core.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Counters, gauges and latency distributions of a running daemon
+ *
+ * Recorded by the daemon loop and the build threads, and rendered in the Prometheus text
+ * exposition format by MetricsServer. Latencies are histograms, so the metrics of several
+ * daemons can be aggregated; per-target build durations are summaries whose quantiles are
+ * computed over the most recent builds of each target.
+ */
+class DaemonMetrics {
+public:
+    /**
+     * @brief Records the time from detecting a change to starting the rebuild it triggered
+     */
+    void record_change_latency(double seconds);
+
+    /**
+     * @brief Records a finished (or cancelled) rebuild
+     */
+    void record_build(E_RESULT result, double seconds);
+
+    /**
+     * @brief Records an executed action
+     * @param target Target or rule name
+     * @param platform Platform the target was built for, empty for rules
+     * @param result Result of the action
+     * @param seconds Time the action took
+     */
+    void record_action(const std::string& target, const std::string& platform, E_RESULT result, double seconds);
+
+    /**
+     * @brief Records a cache lookup
+     * @param cache Name of the cache
+     * @param hit true if the cached result was used
+     */
+    void record_cache_lookup(const std::string& cache, bool hit);
+
+    /**
+     * @brief Sets the number of files the daemon watches
+     */
+    void set_watched_files(size_t count);
+
+    /**
+     * @brief Sets the number of actions waiting to be built
+     */
+    void set_queue_depth(size_t count);
+
+    /**
+     * @brief Renders all metrics in the Prometheus text exposition format
+     */
+    std::string render() const;
+
+private:
+    /**
+     * @brief Cumulative histogram with fixed bucket bounds
+     */
+    struct Histogram {
+        std::vector<double> bounds;
+        std::vector<uint64_t> counts;  // One per bound, plus +Inf
+        double sum = 0;
+        uint64_t count = 0;
+
+        explicit Histogram(std::vector<double> upper_bounds);
+        void observe(double value);
+    };
+
+    /**
+     * @brief Durations of the recent builds of one action
+     */
+    struct ActionDurations {
+        std::deque<double> recent;
+        double sum = 0;
+        uint64_t count = 0;
+    };
+
+    static const size_t RECENT_DURATIONS = 1000;
+
+    mutable std::mutex mutex_;
+    Histogram change_latency_{{0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10}};
+    Histogram build_duration_{{0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120, 300, 600}};
+    std::map<std::string, uint64_t> builds_;                                      // By result
+    std::map<std::pair<std::string, std::string>, ActionDurations> durations_;    // By (target, platform)
+    std::map<std::pair<std::string, std::string>, uint64_t> action_failures_;     // By (target, platform)
+    std::map<std::pair<std::string, bool>, uint64_t> cache_lookups_;              // By (cache, hit)
+    size_t watched_files_ = 0;
+    size_t queue_depth_ = 0;
+
+    /**
+     * @brief Escapes a label value
+     */
+    static std::string escape_label(const std::string& value);
+
+    /**
+     * @brief Formats a sample value
+     */
+    static std::string format_value(double value);
+
+    /**
+     * @brief Appends the lines of a histogram
+     */
+    static void render_histogram(std::string& out, const std::string& name, const std::string& help,
+                                 const Histogram& histogram);
+};
+
+#endif // DAEMON_METRICS_H
@@ -0,0 +1,255 @@
+#include "DaemonSocket.h"
+#include "core.h"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char* SOCKET_FILE = BODGE_CACHE_DIR "/daemon.sock";
+
+    // Connection the calling thread's output is sent to, -1 for the console
+    thread_local int output_client = -1;
+
+    // Installed in std::cout and std::cerr; passes the output of threads without a client to the console
+    class ClientOutputBuffer : public std::streambuf {
+    public:
+        explicit ClientOutputBuffer(std::streambuf* console) : console_(console) {}
+
+    protected:
+        int_type overflow(int_type ch) override {
+            if (traits_type::eq_int_type(ch, traits_type::eof())) {
+                return traits_type::not_eof(ch);
+            }
+            char c = traits_type::to_char_type(ch);
+            return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+        }
+
+        std::streamsize xsputn(const char* data, std::streamsize size) override {
+            if (output_client < 0) {
+                return console_->sputn(data, size);
+            }
+            // A client that went away must not fail the stream, which other threads share
+            DaemonSocket::write_all(output_client, std::string(data, static_cast<size_t>(size)));
+            return size;
+        }
+
+        int sync() override {
+            return output_client < 0 ? console_->pubsync() : 0;
+        }
+
+    private:
+        std::streambuf* console_;
+    };
+
+#ifndef _WIN32
+    // Relative to the project root, which keeps the path within the length limit of sun_path
+    bool socket_address(sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (std::strlen(SOCKET_FILE) >= sizeof(address.sun_path)) {
+            return false;
+        }
+        std::strcpy(address.sun_path, SOCKET_FILE);
+        return true;
+    }
+
+    int open_socket() {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0) {
+            // Compiler processes must not keep the socket open
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        return fd;
+    }
+#endif
+}
+
+DaemonSocket::~DaemonSocket() {
+    close();
+}
+
+bool DaemonSocket::listen() {
+#ifdef _WIN32
+    return false;
+#else
+    sockaddr_un address;
+    if (fd_ >= 0 || !socket_address(address)) {
+        return fd_ >= 0;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(BODGE_CACHE_DIR, ec);
+    unlink(SOCKET_FILE);
+
+    fd_ = open_socket();
+    if (fd_ < 0) {
+        return false;
+    }
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd_, 8) < 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+#endif
+}
+
+int DaemonSocket::accept_client(int timeout_ms) {
+#ifdef _WIN32
+    (void)timeout_ms;
+    return -1;
+#else
+    if (fd_ < 0) {
+        return -1;
+    }
+    pollfd descriptor = {fd_, POLLIN, 0};
+    if (poll(&descriptor, 1, timeout_ms) <= 0) {
+        return -1;
+    }
+    int client = accept(fd_, nullptr, nullptr);
+    if (client >= 0) {
+        fcntl(client, F_SETFD, FD_CLOEXEC);
+    }
+    return client;
+#endif
+}
+
+void DaemonSocket::close() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        ::close(fd_);
+        unlink(SOCKET_FILE);
+    }
+#endif
+    fd_ = -1;
+}
+
+int DaemonSocket::connect() {
+#ifdef _WIN32
+    return -1;
+#else
+    sockaddr_un address;
+    if (!socket_address(address) || !std::filesystem::exists(SOCKET_FILE)) {
+        return -1;
+    }
+    int fd = open_socket();
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#endif
+}
+
+bool DaemonSocket::write_all(int fd, const std::string& data) {
+#ifdef _WIN32
+    (void)fd;
+    (void)data;
+    return false;
+#else
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+    return true;
+#endif
+}
+
+bool DaemonSocket::read_line(int fd, std::string& line) {
+    line.clear();
+#ifdef _WIN32
+    (void)fd;
+    return false;
+#else
+    char c;
+    while (true) {
+        ssize_t result = read(fd, &c, 1);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        if (c == '\n') {
+            return true;
+        }
+        line += c;
+    }
+#endif
+}
+
+bool DaemonSocket::read_available(int fd, std::string& data) {
+#ifdef _WIN32
+    (void)fd;
+    (void)data;
+    return false;
+#else
+    char buffer[4096];
+    while (true) {
+        ssize_t result = read(fd, buffer, sizeof(buffer));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        data.append(buffer, static_cast<size_t>(result));
+        return true;
+    }
+#endif
+}
+
+void DaemonSocket::redirect_output(int fd) {
+#ifdef _WIN32
+    (void)fd;
+#else
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        static ClientOutputBuffer out_buffer(std::cout.rdbuf());
+        static ClientOutputBuffer err_buffer(std::cerr.rdbuf());
+        std::cout.rdbuf(&out_buffer);
+        std::cerr.rdbuf(&err_buffer);
+    });
+    std::cout.flush();
+    std::cerr.flush();
+    output_client = fd;
+    if (fd < 0) {
+        std::cout.clear();
+        std::cerr.clear();
+    }
+#endif
+}
+
+int DaemonSocket::get_output_client() {
+    return output_client;
+}
+
+void DaemonSocket::close_connection(int fd) {
+#ifndef _WIN32
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#else
+    (void)fd;
+#endif
+}
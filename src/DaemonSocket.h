@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef DAEMON_SOCKET_H
+#define DAEMON_SOCKET_H
+
+#include <string>
+
+/**
+ * @brief Unix domain socket through which a running daemon serves build requests
+ *
+ * The daemon listens on a socket in the cache directory. A client sends a single request
+ * line and then reads the output of the build until a result line, which starts with
+ * RESULT_MARKER followed by the E_RESULT code of the build. Host processes that reload a
+ * shared library keep their connection open instead (see LibraryReloader). Not available
+ * on Windows.
+ */
+class DaemonSocket {
+public:
+    /**
+     * @brief Prefix of the line that ends a response
+     */
+    static const char RESULT_MARKER = '\x01';
+
+    DaemonSocket() = default;
+    ~DaemonSocket();
+    DaemonSocket(const DaemonSocket&) = delete;
+    DaemonSocket& operator=(const DaemonSocket&) = delete;
+
+    /**
+     * @brief Starts listening, replacing a socket file left behind by an earlier daemon
+     *
+     * Only the holder of the build lock may listen, so an existing socket file is always stale.
+     * @return true if the socket is listening
+     */
+    bool listen();
+
+    /**
+     * @brief Waits for a client to connect
+     * @param timeout_ms Maximum time to wait, 0 to only check
+     * @return Descriptor of the connection, or -1 if no client connected
+     */
+    int accept_client(int timeout_ms);
+
+    /**
+     * @brief Stops listening and removes the socket file
+     */
+    void close();
+
+    /**
+     * @brief Connects to the daemon of the project in the current directory
+     * @return Descriptor of the connection, or -1 if no daemon is listening
+     */
+    static int connect();
+
+    /**
+     * @brief Writes all data to a connection
+     * @return false if the connection was closed
+     */
+    static bool write_all(int fd, const std::string& data);
+
+    /**
+     * @brief Reads one line (without the newline) from a connection
+     * @return false if the connection was closed before a complete line
+     */
+    static bool read_line(int fd, std::string& line);
+
+    /**
+     * @brief Waits for data on a connection and appends what is available
+     * @return false if the connection was closed
+     */
+    static bool read_available(int fd, std::string& data);
+
+    /**
+     * @brief Sends what the calling thread writes to std::cout and std::cerr to a connection
+     *
+     * Only the calling thread is redirected, so tests and other threads of the daemon keep
+     * writing to the console. Threads started for a request's build redirect themselves to
+     * get_output_client(), and commands they run have their output captured and written to
+     * std::cout.
+     * @param fd Connection to write the output to, or -1 to write to the console again
+     */
+    static void redirect_output(int fd);
+
+    /**
+     * @brief Gets the connection the calling thread's output is sent to
+     * @return Descriptor of the connection, or -1 if the thread writes to the console
+     */
+    static int get_output_client();
+
+    /**
+     * @brief Closes a connection
+     */
+    static void close_connection(int fd);
+
+private:
+    int fd_ = -1;
+};
+
+#endif // DAEMON_SOCKET_H
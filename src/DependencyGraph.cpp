@@ -0,0 +1,106 @@
+#include "DependencyGraph.h"
+#include <algorithm>
+#include <queue>
+#include <functional>
+
+DependencyGraph::DependencyGraph(size_t node_count, std::vector<std::pair<uint32_t, uint32_t>> edges)
+    : offsets_(node_count + 1, 0) {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Count successors per node, then turn counts into row offsets
+    for (const auto& [from, to] : edges) {
+        offsets_[from + 1]++;
+    }
+    for (size_t i = 1; i < offsets_.size(); ++i) {
+        offsets_[i] += offsets_[i - 1];
+    }
+
+    edges_.reserve(edges.size());
+    for (const auto& [from, to] : edges) {
+        edges_.push_back(to);
+    }
+}
+
+size_t DependencyGraph::node_count() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+size_t DependencyGraph::edge_count() const {
+    return edges_.size();
+}
+
+DependencyGraph::Range DependencyGraph::successors(uint32_t node) const {
+    if (node >= node_count()) {
+        return {nullptr, nullptr};
+    }
+    const uint32_t* base = edges_.data();
+    return {base + offsets_[node], base + offsets_[node + 1]};
+}
+
+DependencyGraph DependencyGraph::reversed() const {
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(edges_.size());
+    for (uint32_t node = 0; node < node_count(); ++node) {
+        for (uint32_t successor : successors(node)) {
+            edges.emplace_back(successor, node);
+        }
+    }
+    return DependencyGraph(node_count(), std::move(edges));
+}
+
+bool DependencyGraph::topological_order(std::vector<uint32_t>& order) const {
+    size_t count = node_count();
+    std::vector<uint32_t> in_degree(count, 0);
+    for (uint32_t target : edges_) {
+        in_degree[target]++;
+    }
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+    for (uint32_t node = 0; node < count; ++node) {
+        if (in_degree[node] == 0) {
+            ready.push(node);
+        }
+    }
+
+    order.clear();
+    order.reserve(count);
+    while (!ready.empty()) {
+        uint32_t current = ready.top();
+        ready.pop();
+        order.push_back(current);
+
+        for (uint32_t successor : successors(current)) {
+            if (--in_degree[successor] == 0) {
+                ready.push(successor);
+            }
+        }
+    }
+
+    return order.size() == count;
+}
+
+std::vector<bool> DependencyGraph::reachable_from(const std::vector<uint32_t>& start) const {
+    std::vector<bool> reached(node_count(), false);
+    std::vector<uint32_t> pending;
+
+    for (uint32_t node : start) {
+        if (node < reached.size() && !reached[node]) {
+            reached[node] = true;
+            pending.push_back(node);
+        }
+    }
+
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+        for (uint32_t successor : successors(current)) {
+            if (!reached[successor]) {
+                reached[successor] = true;
+                pending.push_back(successor);
+            }
+        }
+    }
+
+    return reached;
+}
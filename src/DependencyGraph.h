@@ -0,0 +1,82 @@
+#pragma once
+
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Immutable directed graph stored in compressed sparse-row (CSR) form
+ *
+ * Nodes are dense indices 0 .. node_count()-1 (typically PathIds or positions in a
+ * file list). The successors of node n are edges()[offsets[n] .. offsets[n+1]),
+ * so walking the graph touches two contiguous arrays instead of chasing map nodes.
+ */
+class DependencyGraph {
+public:
+    /**
+     * @brief Contiguous range of successor indices
+     */
+    struct Range {
+        const uint32_t* first;
+        const uint32_t* last;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    DependencyGraph() = default;
+
+    /**
+     * @brief Builds the graph from an edge list
+     * @param node_count Number of nodes
+     * @param edges Pairs of (from, to); duplicates are removed
+     */
+    DependencyGraph(size_t node_count, std::vector<std::pair<uint32_t, uint32_t>> edges);
+
+    /**
+     * @brief Gets the number of nodes
+     */
+    size_t node_count() const;
+
+    /**
+     * @brief Gets the number of edges
+     */
+    size_t edge_count() const;
+
+    /**
+     * @brief Gets the successors of a node
+     * @param node Node index
+     * @return Range of successor node indices
+     */
+    Range successors(uint32_t node) const;
+
+    /**
+     * @brief Builds the graph with all edges reversed
+     * @return Graph where every edge (a, b) becomes (b, a)
+     */
+    DependencyGraph reversed() const;
+
+    /**
+     * @brief Computes a topological order (nodes before their successors)
+     * @param order Receives the node order; ties are broken by lowest index first
+     * @return false if the graph contains a cycle
+     */
+    bool topological_order(std::vector<uint32_t>& order) const;
+
+    /**
+     * @brief Marks every node reachable from a set of start nodes
+     * @param start Start nodes (marked themselves)
+     * @return Flag per node, true if reachable
+     */
+    std::vector<bool> reachable_from(const std::vector<uint32_t>& start) const;
+
+private:
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> edges_;
+};
+
+#endif // DEPENDENCY_GRAPH_H
@@ -1,20 +1,27 @@
 #include "FileSystemUtils.h"
 #include "StringUtils.h"
+#include "IncludeGraph.h"
 #include <filesystem>
+#include <unordered_map>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <regex>
-#include <map>
-#include <queue>
+#include <set>
+#include <chrono>
 
 #ifdef _WIN32
     #define PATH_SEPARATOR "\\"
 #else
     #define PATH_SEPARATOR "/"
+    #include <sys/stat.h>
+    #include <cerrno>
+    #include <fcntl.h>
 #endif
 
-std::vector<std::string> FileSystemUtils::expand_source_patterns(const std::vector<std::string>& patterns) {
+std::vector<std::string> FileSystemUtils::expand_source_patterns(const std::vector<std::string>& patterns,
+                                                                 const std::vector<std::string>& include_dirs,
+                                                                 DirectoryStamps* scanned_dirs) {
     std::vector<std::string> result;
     std::set<std::string> unique_files; // Prevent duplicates
     
@@ -23,6 +30,14 @@ std::vector<std::string> FileSystemUtils::expand_source_patterns(const std::vect
         
         // Check if it's a direct file reference (no wildcards)
         if (trimmed_pattern.find('*') == std::string::npos) {
+            if (scanned_dirs != nullptr) {
+                // The file appearing or disappearing changes its directory
+                std::string parent = std::filesystem::path(trimmed_pattern).parent_path().string();
+                if (parent.empty()) {
+                    parent = ".";
+                }
+                (*scanned_dirs)[parent] = get_modification_time(parent);
+            }
             if (file_exists(trimmed_pattern)) {
                 unique_files.insert(normalize_path(trimmed_pattern));
             }
@@ -41,13 +56,13 @@ std::vector<std::string> FileSystemUtils::expand_source_patterns(const std::vect
         
         // Check for recursive pattern (**)
         if (file_pattern == "**" || file_pattern.find("**") != std::string::npos) {
-            std::vector<std::string> found_files = find_cpp_files(directory, true);
+            std::vector<std::string> found_files = find_cpp_files(directory, true, scanned_dirs);
             for (const std::string& file : found_files) {
                 unique_files.insert(normalize_path(file));
             }
         } else {
             // Single directory pattern
-            std::vector<std::string> found_files = find_cpp_files(directory, false);
+            std::vector<std::string> found_files = find_cpp_files(directory, false, scanned_dirs);
             for (const std::string& file : found_files) {
                 if (match_pattern(std::filesystem::path(file).filename().string(), file_pattern)) {
                     unique_files.insert(normalize_path(file));
@@ -61,15 +76,144 @@ std::vector<std::string> FileSystemUtils::expand_source_patterns(const std::vect
     
     // Analyze dependencies and sort files in build order
     if (result.size() > 1) {
-        result = analyze_dependencies(result);
+        result = analyze_dependencies(result, include_dirs);
     }
     
     return result;
 }
 
-std::vector<std::string> FileSystemUtils::find_cpp_files(const std::string& directory, bool recursive) {
+namespace {
+    // Splits a wildcard pattern into its directory, file name pattern and recursion flag
+    void split_pattern(const std::string& pattern, std::string& directory, std::string& file_pattern, bool& recursive) {
+        size_t recursive_pos = pattern.find("**");
+        recursive = recursive_pos != std::string::npos;
+
+        if (recursive) {
+            directory = pattern.substr(0, recursive_pos);
+            std::string rest = pattern.substr(recursive_pos + 2);
+            file_pattern = rest.empty() ? "*" : (rest[0] == '/' || rest[0] == '\\') ? rest.substr(1) : "*" + rest;
+        } else {
+            size_t slash_pos = pattern.find_last_of("/\\");
+            directory = slash_pos != std::string::npos ? pattern.substr(0, slash_pos) : "";
+            file_pattern = slash_pos != std::string::npos ? pattern.substr(slash_pos + 1) : pattern;
+        }
+
+        while (!directory.empty() && (directory.back() == '/' || directory.back() == '\\')) {
+            directory.pop_back();
+        }
+        if (directory.empty()) {
+            directory = ".";
+        }
+    }
+}
+
+std::vector<std::string> FileSystemUtils::expand_file_patterns(const std::vector<std::string>& patterns,
+                                                               DirectoryStamps* scanned_dirs) {
+    std::vector<std::string> result;
+    std::set<std::string> seen;
+
+    for (const std::string& pattern : patterns) {
+        std::string trimmed_pattern = StringUtils::trim(pattern);
+
+        if (trimmed_pattern.find('*') == std::string::npos) {
+            std::string path = normalize_path(trimmed_pattern);
+            if (seen.insert(path).second) {
+                result.push_back(path);
+            }
+            continue;
+        }
+
+        std::string directory;
+        std::string file_pattern;
+        bool recursive;
+        split_pattern(trimmed_pattern, directory, file_pattern, recursive);
+
+        if (scanned_dirs != nullptr) {
+            (*scanned_dirs)[directory] = get_modification_time(directory);
+        }
+        if (!directory_exists(directory)) {
+            std::cerr << "[WARNING] Directory does not exist: " << directory << std::endl;
+            continue;
+        }
+
+        std::vector<std::string> found;
+        try {
+            auto collect = [&](const std::filesystem::directory_entry& entry) {
+                if (entry.is_regular_file() && match_pattern(entry.path().filename().string(), file_pattern)) {
+                    found.push_back(normalize_path(entry.path().string()));
+                } else if (scanned_dirs != nullptr && entry.is_directory()) {
+                    (*scanned_dirs)[entry.path().string()] = get_modification_time(entry.path().string());
+                }
+            };
+            if (recursive) {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+                    collect(entry);
+                }
+            } else {
+                for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                    collect(entry);
+                }
+            }
+        } catch (const std::filesystem::filesystem_error& e) {
+            std::cerr << "[ERROR] Failed to access directory " << directory << ": " << e.what() << std::endl;
+        }
+
+        // Directory iteration order is unspecified
+        std::sort(found.begin(), found.end());
+        for (const std::string& path : found) {
+            if (seen.insert(path).second) {
+                result.push_back(path);
+            }
+        }
+    }
+
+    return result;
+}
+
+bool FileSystemUtils::pattern_covers(const std::string& pattern, const std::string& path, bool sources_only) {
+    std::string trimmed_pattern = StringUtils::trim(pattern);
+    std::filesystem::path normalized = std::filesystem::path(path).lexically_normal();
+
+    if (trimmed_pattern.find('*') == std::string::npos) {
+        return std::filesystem::path(trimmed_pattern).lexically_normal() == normalized;
+    }
+
+    if (sources_only && !is_cpp_source_file(path)) {
+        return false;
+    }
+
+    std::string directory;
+    std::string file_pattern;
+    bool recursive;
+    split_pattern(trimmed_pattern, directory, file_pattern, recursive);
+
+    // Source patterns collect every source below a "**" directory, whatever follows it
+    if (!(recursive && sources_only) && !match_pattern(normalized.filename().string(), file_pattern)) {
+        return false;
+    }
+
+    std::filesystem::path parent = normalized.parent_path();
+    std::filesystem::path root = std::filesystem::path(directory).lexically_normal();
+    if (root == ".") {
+        return recursive || parent.empty();
+    }
+    if (!recursive) {
+        return parent == root;
+    }
+
+    // The path lies below the root if the root is a prefix of its parent
+    auto mismatch = std::mismatch(root.begin(), root.end(), parent.begin(), parent.end());
+    return mismatch.first == root.end();
+}
+
+std::vector<std::string> FileSystemUtils::find_cpp_files(const std::string& directory, bool recursive,
+                                                         DirectoryStamps* scanned_dirs) {
     std::vector<std::string> files;
     
+    if (scanned_dirs != nullptr) {
+        (*scanned_dirs)[directory] = get_modification_time(directory);
+    }
+    
     if (!directory_exists(directory)) {
         std::cerr << "[WARNING] Directory does not exist: " << directory << std::endl;
         return files;
@@ -80,6 +224,8 @@ std::vector<std::string> FileSystemUtils::find_cpp_files(const std::string& dire
             for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
                 if (entry.is_regular_file() && is_cpp_source_file(entry.path().string())) {
                     files.push_back(entry.path().string());
+                } else if (scanned_dirs != nullptr && entry.is_directory()) {
+                    (*scanned_dirs)[entry.path().string()] = get_modification_time(entry.path().string());
                 }
             }
         } else {
@@ -114,15 +260,20 @@ bool FileSystemUtils::is_cpp_header_file(const std::string& filename) {
            extension == ".hxx" || extension == ".h++";
 }
 
-std::vector<std::string> FileSystemUtils::analyze_dependencies(const std::vector<std::string>& source_files) {
-    std::map<std::string, std::set<std::string>> dependencies;
-    std::map<std::string, std::string> header_to_source;
+std::vector<std::string> FileSystemUtils::analyze_dependencies(const std::vector<std::string>& source_files,
+                                                               const std::vector<std::string>& include_dirs) {
+    PathTable& paths = PathTable::shared();
+    std::unordered_map<PathId, uint32_t> header_to_source;
     
-    // First pass: build header to source mapping
-    for (const std::string& source_file : source_files) {
-        std::filesystem::path source_path(source_file);
+    // First pass: build header to source mapping (keyed by full path, so equally
+    // named headers in different directories don't collide)
+    for (uint32_t index = 0; index < source_files.size(); ++index) {
+        std::filesystem::path source_path(source_files[index]);
         std::string base_name = source_path.stem().string();
         std::string dir = source_path.parent_path().string();
+        if (dir.empty()) {
+            dir = ".";
+        }
         
         // Look for corresponding header file
         std::vector<std::string> possible_headers = {
@@ -133,29 +284,28 @@ std::vector<std::string> FileSystemUtils::analyze_dependencies(const std::vector
         
         for (const std::string& header : possible_headers) {
             if (file_exists(header)) {
-                header_to_source[std::filesystem::path(header).filename().string()] = source_file;
+                header_to_source[paths.intern(normalize_path(header))] = index;
                 break;
             }
         }
     }
     
-    // Second pass: analyze includes
-    for (const std::string& source_file : source_files) {
-        dependencies[source_file] = std::set<std::string>();
-        std::set<std::string> includes = extract_local_includes(source_file);
-        
-        for (const std::string& include : includes) {
-            if (header_to_source.find(include) != header_to_source.end()) {
-                std::string dep_source = header_to_source[include];
-                if (dep_source != source_file) {
-                    dependencies[source_file].insert(dep_source);
-                }
+    // Second pass: analyze transitive includes, edges point from a source to the
+    // sources implementing the headers it includes
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    IncludeGraph include_graph(include_dirs);
+    for (uint32_t index = 0; index < source_files.size(); ++index) {
+        for (PathId include : include_graph.get_transitive_includes(source_files[index])) {
+            auto it = header_to_source.find(include);
+            if (it != header_to_source.end() && it->second != index) {
+                edges.emplace_back(index, it->second);
             }
         }
     }
+    IncludeGraph::save_cache();
     
     // Perform topological sort
-    return topological_sort(dependencies);
+    return topological_sort(source_files, DependencyGraph(source_files.size(), std::move(edges)));
 }
 
 bool FileSystemUtils::directory_exists(const std::string& path) {
@@ -166,6 +316,59 @@ bool FileSystemUtils::file_exists(const std::string& path) {
     return std::filesystem::exists(path) && std::filesystem::is_regular_file(path);
 }
 
+bool FileSystemUtils::get_file_stamp(const std::string& path, FileStamp& stamp) {
+#ifdef _WIN32
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.mtime = static_cast<long long>(mtime.time_since_epoch().count());
+    stamp.size = static_cast<unsigned long long>(size);
+    stamp.inode = 0;
+    return true;
+#else
+#if defined(__linux__) && defined(STATX_MTIME)
+    // statx fetches only the requested fields, which is cheaper on network file systems
+    struct statx stx;
+    if (statx(AT_FDCWD, path.c_str(), 0, STATX_MTIME | STATX_SIZE | STATX_INO, &stx) == 0) {
+        stamp.mtime = static_cast<long long>(stx.stx_mtime.tv_sec) * 1000000000LL + stx.stx_mtime.tv_nsec;
+        stamp.size = static_cast<unsigned long long>(stx.stx_size);
+        stamp.inode = static_cast<unsigned long long>(stx.stx_ino);
+        return true;
+    }
+    if (errno != ENOSYS) {
+        return false;
+    }
+#endif
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+#ifdef __APPLE__
+    stamp.mtime = static_cast<long long>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    stamp.mtime = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    stamp.size = static_cast<unsigned long long>(st.st_size);
+    stamp.inode = static_cast<unsigned long long>(st.st_ino);
+    return true;
+#endif
+}
+
+long long FileSystemUtils::get_modification_time(const std::string& path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return -1;
+    }
+    return static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count());
+}
+
 std::string FileSystemUtils::normalize_path(const std::string& path) {
     std::filesystem::path p(path);
     return p.lexically_normal().string();
@@ -187,76 +390,21 @@ bool FileSystemUtils::match_pattern(const std::string& filename, const std::stri
     return std::regex_match(filename, matcher);
 }
 
-std::set<std::string> FileSystemUtils::extract_local_includes(const std::string& filepath) {
-    std::set<std::string> includes;
-    std::ifstream file(filepath);
+std::vector<std::string> FileSystemUtils::topological_sort(const std::vector<std::string>& files,
+                                                           const DependencyGraph& dependencies) {
+    std::vector<uint32_t> order;
     
-    if (!file.is_open()) {
-        return includes;
-    }
-    
-    std::string line;
-    std::regex include_regex("^\\s*#\\s*include\\s*\"([^\"]+)\"\\s*");
-    
-    while (std::getline(file, line)) {
-        std::smatch match;
-        if (std::regex_match(line, match, include_regex)) {
-            std::string included_file = match[1].str();
-            // Only consider local includes (in quotes, not angle brackets)
-            includes.insert(std::filesystem::path(included_file).filename().string());
-        }
+    // If there's a cycle, return original order
+    if (!dependencies.topological_order(order)) {
+        std::cerr << "[WARNING] Circular dependency detected. Using original file order." << std::endl;
+        return files;
     }
     
-    return includes;
-}
-
-std::vector<std::string> FileSystemUtils::topological_sort(const std::map<std::string, std::set<std::string>>& dependencies) {
     std::vector<std::string> result;
-    std::map<std::string, int> in_degree;
-    std::queue<std::string> zero_in_degree;
-    
-    // Initialize in-degree count
-    for (const auto& pair : dependencies) {
-        if (in_degree.find(pair.first) == in_degree.end()) {
-            in_degree[pair.first] = 0;
-        }
-        for (const std::string& dep : pair.second) {
-            in_degree[dep]++;
-        }
-    }
-    
-    // Find all nodes with in-degree 0
-    for (const auto& pair : in_degree) {
-        if (pair.second == 0) {
-            zero_in_degree.push(pair.first);
-        }
-    }
-    
-    // Process nodes
-    while (!zero_in_degree.empty()) {
-        std::string current = zero_in_degree.front();
-        zero_in_degree.pop();
-        result.push_back(current);
-        
-        // Reduce in-degree for dependent nodes
-        if (dependencies.find(current) != dependencies.end()) {
-            for (const std::string& dependent : dependencies.at(current)) {
-                in_degree[dependent]--;
-                if (in_degree[dependent] == 0) {
-                    zero_in_degree.push(dependent);
-                }
-            }
-        }
-    }
-    
-    // If result size doesn't match input, there's a cycle - return original order
-    if (result.size() != dependencies.size()) {
-        std::cerr << "[WARNING] Circular dependency detected. Using original file order." << std::endl;
-        result.clear();
-        for (const auto& pair : dependencies) {
-            result.push_back(pair.first);
-        }
+    result.reserve(order.size());
+    for (uint32_t index : order) {
+        result.push_back(files[index]);
     }
     
     return result;
-}
\ No newline at end of file
+}
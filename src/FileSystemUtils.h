@@ -7,6 +7,27 @@
 #include <vector>
 #include <set>
 #include <map>
+#include "DependencyGraph.h"
+
+/**
+ * @brief Identity of a file on disk, used to detect whether cached data is still valid
+ */
+struct FileStamp {
+    long long mtime = 0;            // Last modification time in nanoseconds
+    unsigned long long size = 0;    // File size in bytes
+    unsigned long long inode = 0;   // Inode number (0 where the platform has none)
+
+    bool operator==(const FileStamp& other) const {
+        return mtime == other.mtime && size == other.size && inode == other.inode;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Directories listed while expanding source patterns, mapped to their
+ *        modification time at listing time (-1 if the directory did not exist)
+ */
+typedef std::map<std::string, long long> DirectoryStamps;
 
 /**
  * @brief Utility class for file system operations and automatic source collection
@@ -16,17 +37,46 @@ public:
     /**
      * @brief Expands source patterns to actual file paths
      * @param patterns Vector of source patterns
+     * @param include_dirs Include directories used to resolve #include directives for ordering
+     * @param scanned_dirs If given, receives every directory the patterns depend on
      * @return Vector of resolved file paths
      */
-    static std::vector<std::string> expand_source_patterns(const std::vector<std::string>& patterns);
+    static std::vector<std::string> expand_source_patterns(const std::vector<std::string>& patterns,
+                                                           const std::vector<std::string>& include_dirs = {},
+                                                           DirectoryStamps* scanned_dirs = nullptr);
     
+    /**
+     * @brief Expands file patterns into files of any type
+     *
+     * Patterns work like source patterns, but match every file instead of only C/C++
+     * sources. A single "*" matches file names in one directory, a "**" directory
+     * searches recursively and may be followed by a file name pattern. Paths without
+     * wildcards are kept even if the file does not exist yet.
+     * @param patterns File patterns to expand
+     * @param scanned_dirs If given, receives every directory the patterns depend on
+     * @return Vector of file paths in pattern order
+     */
+    static std::vector<std::string> expand_file_patterns(const std::vector<std::string>& patterns,
+                                                         DirectoryStamps* scanned_dirs = nullptr);
+
+    /**
+     * @brief Checks if a pattern covers a path, without looking at the file system
+     * @param pattern A source or file pattern
+     * @param path The path to check
+     * @param sources_only Whether wildcards only cover C/C++ source files, as in source patterns
+     * @return true if expanding the pattern would yield the path once the file exists
+     */
+    static bool pattern_covers(const std::string& pattern, const std::string& path, bool sources_only = true);
+
     /**
      * @brief Recursively finds all C/C++ source files in a directory
      * @param directory The directory to search (e.g., "src")
      * @param recursive Whether to search subdirectories
+     * @param scanned_dirs If given, receives every directory that was listed
      * @return Vector of C/C++ source file paths
      */
-    static std::vector<std::string> find_cpp_files(const std::string& directory, bool recursive = false);
+    static std::vector<std::string> find_cpp_files(const std::string& directory, bool recursive = false,
+                                                   DirectoryStamps* scanned_dirs = nullptr);
     
     /**
      * @brief Checks if a file has a C/C++ source extension
@@ -45,9 +95,11 @@ public:
     /**
      * @brief Analyzes dependencies between C/C++ files to determine build order
      * @param source_files Vector of source file paths
+     * @param include_dirs Include directories used to resolve #include directives
      * @return Vector of source files ordered by dependencies
      */
-    static std::vector<std::string> analyze_dependencies(const std::vector<std::string>& source_files);
+    static std::vector<std::string> analyze_dependencies(const std::vector<std::string>& source_files,
+                                                         const std::vector<std::string>& include_dirs = {});
     
     /**
      * @brief Checks if a directory exists
@@ -63,6 +115,21 @@ public:
      */
     static bool file_exists(const std::string& path);
     
+    /**
+     * @brief Reads modification time, size and inode of a file
+     * @param path File path
+     * @param stamp Receives the file identity
+     * @return true if the file exists and could be queried
+     */
+    static bool get_file_stamp(const std::string& path, FileStamp& stamp);
+
+    /**
+     * @brief Gets the modification time of a file or directory
+     * @param path Path to query
+     * @return Modification time in nanoseconds, or -1 if the path does not exist
+     */
+    static long long get_modification_time(const std::string& path);
+
     /**
      * @brief Normalizes path separators for current platform
      * @param path Path to normalize
@@ -87,19 +154,14 @@ private:
      */
     static bool match_pattern(const std::string& filename, const std::string& pattern);
     
-    /**
-     * @brief Extracts #include statements from a C/C++ file
-     * @param filepath Path to the C/C++ file
-     * @return Set of included header files (local includes only)
-     */
-    static std::set<std::string> extract_local_includes(const std::string& filepath);
-    
     /**
      * @brief Performs topological sort for dependency ordering
-     * @param dependencies Map of file -> set of dependencies
+     * @param files Files in their original order (graph node i is files[i])
+     * @param dependencies Graph with an edge from each file to the files it depends on
      * @return Vector of files in dependency order
      */
-    static std::vector<std::string> topological_sort(const std::map<std::string, std::set<std::string>>& dependencies);
+    static std::vector<std::string> topological_sort(const std::vector<std::string>& files,
+                                                     const DependencyGraph& dependencies);
 };
 
 #endif // FILESYSTEM_UTILS_H
\ No newline at end of file
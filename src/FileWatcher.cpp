@@ -1,14 +1,76 @@
 #include "FileWatcher.h"
 #include "FileSystemUtils.h"
+#include "ContentHash.h"
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <thread>
 
-FileWatcher::FileWatcher(const std::vector<std::string>& watch_paths)
-    : watch_paths_(watch_paths) {
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    // Written files, atomic saves (rename over the original), new files and directories, removals
+    const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+    // Minimum number of files each polling thread stats
+    const size_t STAT_BATCH_SIZE = 2048;
+
+    std::string join_path(const std::string& directory, const std::string& name) {
+        return directory.empty() ? name : directory + "/" + name;
+    }
+
+    // Number of threads used to process a number of files
+    size_t slice_count(size_t items) {
+        return std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                std::max<size_t>(1, items / STAT_BATCH_SIZE));
+    }
+
+    // Calls function(slice, begin, end) for each slice of [0, items), all but the first on a separate thread
+    template <typename Function>
+    void run_slices(size_t items, size_t slices, const Function& function) {
+        std::vector<std::thread> workers;
+        for (size_t slice = 1; slice < slices; ++slice) {
+            workers.emplace_back(function, slice, items * slice / slices, items * (slice + 1) / slices);
+        }
+        function(0, 0, items / slices);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    uint64_t fingerprint(const std::string& path) {
+        uint64_t hash = 0;
+        ContentHash::hash_file(path, hash);
+        return hash;
+    }
+}
+
+FileWatcher::FileWatcher(const std::vector<std::string>& watch_paths, WatcherBackend backend)
+    : backend_(backend), watch_paths_(watch_paths) {
+}
+
+FileWatcher::~FileWatcher() {
+    stop_inotify();
 }
 
 bool FileWatcher::initialize() {
-    file_timestamps_.clear();
+    // Fingerprints of files that were already watched and did not change are kept
+    std::vector<WatchedFile> previous = std::move(files_);
+    std::vector<uint32_t> previous_index = std::move(file_index_);
+    files_.clear();
+    file_index_.clear();
+    directories_.clear();
+    directory_index_.clear();
     
     try {
         for (const std::string& path : watch_paths_) {
@@ -17,16 +79,23 @@ bool FileWatcher::initialize() {
             if (std::filesystem::is_directory(fs_path)) {
                 scan_directory(path);
             } else if (std::filesystem::is_regular_file(fs_path)) {
-                if (should_watch_file(path)) {
-                    file_timestamps_[path] = get_file_time(path);
+                FileStamp stamp;
+                if (should_watch_file(path) && FileSystemUtils::get_file_stamp(path, stamp)) {
+                    set_file_stamp(PathTable::shared().intern(path), stamp, 0);
                 }
             } else {
                 std::cerr << "[WARNING] Path does not exist or is not accessible: " << path << std::endl;
             }
         }
         
-        std::cout << "[INFO] Watching " << file_timestamps_.size() << " file(s) for changes..." << std::endl;
-        return !file_timestamps_.empty();
+        fingerprint_files(previous, previous_index);
+        std::cout << "[INFO] Watching " << files_.size() << " file(s) for changes..." << std::endl;
+
+        stop_inotify();
+        if (backend_ == WatcherBackend::AUTO && !start_inotify()) {
+            stop_inotify();
+        }
+        return !files_.empty();
     } catch (const std::filesystem::filesystem_error& e) {
         std::cerr << "[ERROR] Failed to initialize file watcher: " << e.what() << std::endl;
         return false;
@@ -37,37 +106,8 @@ bool FileWatcher::has_changes() {
     changed_files_.clear();
     
     try {
-        // Check existing files for modifications
-        for (auto& [file_path, last_time] : file_timestamps_) {
-            if (!std::filesystem::exists(file_path)) {
-                // File was deleted
-                changed_files_.push_back(file_path);
-                continue;
-            }
-            
-            auto current_time = get_file_time(file_path);
-            if (current_time != last_time) {
-                changed_files_.push_back(file_path);
-            }
-        }
-        
-        // Check for new files in watched directories
-        for (const std::string& path : watch_paths_) {
-            if (std::filesystem::is_directory(path)) {
-                for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
-                    if (entry.is_regular_file()) {
-                        std::string file_path = entry.path().string();
-                        if (should_watch_file(file_path) && 
-                            file_timestamps_.find(file_path) == file_timestamps_.end()) {
-                            // New file detected
-                            changed_files_.push_back(file_path);
-                            file_timestamps_[file_path] = get_file_time(file_path);
-                        }
-                    }
-                }
-            }
-        }
-        
+        poll_files();
+        poll_directories();
         return !changed_files_.empty();
     } catch (const std::filesystem::filesystem_error& e) {
         std::cerr << "[ERROR] Error checking for file changes: " << e.what() << std::endl;
@@ -75,19 +115,87 @@ bool FileWatcher::has_changes() {
     }
 }
 
+bool FileWatcher::wait_for_changes(int timeout_ms) {
+    changed_files_.clear();
+    if (!detect_changes(timeout_ms)) {
+        return false;
+    }
+    batch_start_ = std::chrono::steady_clock::now();
+
+    // Collect changes until the files are quiet, remembering each file's fingerprint
+    // from before the batch (none for files that did not exist)
+    std::unordered_map<PathId, std::optional<uint64_t>> initial_hash;
+    std::vector<PathId> batch;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(max_wait_ms_);
+    while (true) {
+        for (PathId id : changed_files_) {
+            if (initial_hash.find(id) == initial_hash.end()) {
+                batch.push_back(id);
+                initial_hash[id] = is_watched(id) ? std::optional<uint64_t>(files_[file_index_[id]].hash) : std::nullopt;
+            }
+        }
+        update_state();
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (debounce_ms_ <= 0 || remaining.count() <= 0 ||
+            !detect_changes(static_cast<int>(std::min<long long>(debounce_ms_, remaining.count())))) {
+            break;
+        }
+    }
+
+    for (PathId id : batch) {
+        const std::optional<uint64_t>& before = initial_hash[id];
+        if (!is_watched(id)) {
+            if (before) {
+                changed_files_.push_back(id); // Deleted
+            }
+            // Otherwise created and removed again within the batch
+        } else if (!before || files_[file_index_[id]].hash != *before) {
+            changed_files_.push_back(id);
+        }
+    }
+    std::sort(changed_files_.begin(), changed_files_.end());
+    return !changed_files_.empty();
+}
+
+void FileWatcher::set_debounce(int debounce_ms, int max_wait_ms) {
+    debounce_ms_ = debounce_ms;
+    max_wait_ms_ = max_wait_ms;
+}
+
+bool FileWatcher::detect_changes(int timeout_ms) {
+    if (is_event_based()) {
+        return read_inotify_events(timeout_ms);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    return has_changes();
+}
+
+bool FileWatcher::is_event_based() const {
+    return inotify_fd_ >= 0;
+}
+
 std::vector<std::string> FileWatcher::get_changed_files() {
-    return changed_files_;
+    std::vector<std::string> files;
+    files.reserve(changed_files_.size());
+    for (PathId id : changed_files_) {
+        files.push_back(PathTable::shared().str(id));
+    }
+    return files;
 }
 
 void FileWatcher::update_state() {
     try {
-        // Update timestamps for all changed files
-        for (const std::string& file_path : changed_files_) {
-            if (std::filesystem::exists(file_path)) {
-                file_timestamps_[file_path] = get_file_time(file_path);
+        // Update stamps for all changed files
+        for (PathId id : changed_files_) {
+            std::string file_path = PathTable::shared().str(id);
+            FileStamp stamp;
+            if (FileSystemUtils::get_file_stamp(file_path, stamp)) {
+                set_file_stamp(id, stamp, fingerprint(file_path));
             } else {
                 // Remove deleted files from tracking
-                file_timestamps_.erase(file_path);
+                remove_file(id);
             }
         }
         changed_files_.clear();
@@ -98,21 +206,40 @@ void FileWatcher::update_state() {
 
 std::vector<std::string> FileWatcher::get_watched_files() const {
     std::vector<std::string> files;
-    files.reserve(file_timestamps_.size());
-    for (const auto& [file_path, _] : file_timestamps_) {
-        files.push_back(file_path);
+    files.reserve(files_.size());
+    for (const WatchedFile& file : files_) {
+        files.push_back(PathTable::shared().str(file.path));
     }
     return files;
 }
 
+size_t FileWatcher::get_watched_count() const {
+    return files_.size();
+}
+
+std::chrono::steady_clock::time_point FileWatcher::get_batch_start() const {
+    return batch_start_;
+}
+
+void FileWatcher::add_change(PathId path) {
+    // New files are watched once update_state() records them
+    if (!is_watched(path) || content_changed(files_[file_index_[path]], PathTable::shared().str(path))) {
+        changed_files_.push_back(path);
+    }
+}
+
 void FileWatcher::scan_directory(const std::string& path) {
     try {
+        // Directory stamps are taken before listing, so files created meanwhile are found by the next poll
+        FileStamp stamp;
+        track_directory(path, FileSystemUtils::get_file_stamp(path, stamp) ? stamp.mtime : -1);
         for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
-            if (entry.is_regular_file()) {
-                std::string file_path = entry.path().string();
-                if (should_watch_file(file_path)) {
-                    file_timestamps_[file_path] = get_file_time(file_path);
-                }
+            std::string entry_path = entry.path().string();
+            if (entry.is_directory()) {
+                track_directory(entry_path, FileSystemUtils::get_file_stamp(entry_path, stamp) ? stamp.mtime : -1);
+            } else if (entry.is_regular_file() && should_watch_file(entry_path) &&
+                       FileSystemUtils::get_file_stamp(entry_path, stamp)) {
+                set_file_stamp(PathTable::shared().intern(entry_path), stamp, 0);
             }
         }
     } catch (const std::filesystem::filesystem_error& e) {
@@ -125,7 +252,338 @@ bool FileWatcher::should_watch_file(const std::string& path) const {
            FileSystemUtils::is_cpp_header_file(path);
 }
 
-std::filesystem::file_time_type FileWatcher::get_file_time(const std::string& path) const {
-    return std::filesystem::last_write_time(path);
+void FileWatcher::set_file_stamp(PathId path, const FileStamp& stamp, uint64_t hash) {
+    if (path >= file_index_.size()) {
+        file_index_.resize(PathTable::shared().size(), NOT_WATCHED);
+    }
+    
+    if (file_index_[path] == NOT_WATCHED) {
+        file_index_[path] = static_cast<uint32_t>(files_.size());
+        files_.push_back({path, stamp, hash});
+    } else {
+        files_[file_index_[path]].stamp = stamp;
+        files_[file_index_[path]].hash = hash;
+    }
+}
+
+bool FileWatcher::content_changed(WatchedFile& file, const std::string& path) {
+    // Deleted files have no stamp; atomic saves change the inode
+    FileStamp stamp;
+    if (!FileSystemUtils::get_file_stamp(path, stamp)) {
+        return true;
+    }
+    if (stamp == file.stamp) {
+        return false;
+    }
+    if (stamp.size != file.stamp.size) {
+        return true;
+    }
+
+    uint64_t hash;
+    if (!ContentHash::hash_file(path, hash) || hash != file.hash) {
+        return true;
+    }
+    file.stamp = stamp;
+    return false;
+}
+
+void FileWatcher::fingerprint_files(const std::vector<WatchedFile>& previous, const std::vector<uint32_t>& previous_index) {
+    const PathTable& paths = PathTable::shared();
+    run_slices(files_.size(), slice_count(files_.size()), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            PathId id = files_[i].path;
+            if (id < previous_index.size() && previous_index[id] != NOT_WATCHED &&
+                previous[previous_index[id]].stamp == files_[i].stamp) {
+                files_[i].hash = previous[previous_index[id]].hash;
+            } else {
+                files_[i].hash = fingerprint(paths.str(id));
+            }
+        }
+    });
+}
+
+bool FileWatcher::set_watch_paths(const std::vector<std::string>& watch_paths) {
+    watch_paths_ = watch_paths;
+    return initialize();
+}
+
+void FileWatcher::remove_file(PathId path) {
+    if (!is_watched(path)) {
+        return;
+    }
+    
+    // Swap with the last entry to keep the list dense
+    uint32_t index = file_index_[path];
+    files_[index] = files_.back();
+    file_index_[files_[index].path] = index;
+    files_.pop_back();
+    file_index_[path] = NOT_WATCHED;
+}
+
+bool FileWatcher::is_watched(PathId path) const {
+    return path < file_index_.size() && file_index_[path] != NOT_WATCHED;
+}
+
+bool FileWatcher::track_directory(const std::string& path, long long mtime) {
+    auto [it, inserted] = directory_index_.emplace(path, static_cast<uint32_t>(directories_.size()));
+    if (inserted) {
+        directories_.push_back({path, true, mtime});
+    }
+    return inserted;
+}
+
+void FileWatcher::poll_files() {
+    // Each thread checks a contiguous slice of the watch list; nothing is interned meanwhile,
+    // so the path table is only read
+    const PathTable& paths = PathTable::shared();
+    size_t slices = slice_count(files_.size());
+    std::vector<std::vector<PathId>> changes(slices);
+    run_slices(files_.size(), slices, [&](size_t slice, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (content_changed(files_[i], paths.str(files_[i].path))) {
+                changes[slice].push_back(files_[i].path);
+            }
+        }
+    });
+
+    for (const std::vector<PathId>& slice_changes : changes) {
+        changed_files_.insert(changed_files_.end(), slice_changes.begin(), slice_changes.end());
+    }
+}
+
+void FileWatcher::poll_directories() {
+    PathTable& paths = PathTable::shared();
+
+    // Creating, removing or renaming an entry updates the modification time of its directory,
+    // so only changed directories are listed. New subdirectories are appended and listed in the same pass.
+    for (size_t i = 0; i < directories_.size(); ++i) {
+        std::string directory = directories_[i].path;
+        FileStamp stamp;
+        if (!FileSystemUtils::get_file_stamp(directory, stamp)) {
+            directories_[i].mtime = -1; // Removed; its files are reported by poll_files()
+            continue;
+        }
+        if (stamp.mtime == directories_[i].mtime) {
+            continue;
+        }
+        directories_[i].mtime = stamp.mtime;
+
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+            std::string entry_path = entry.path().string();
+            if (entry.is_directory(ec)) {
+                track_directory(entry_path, -1);
+            } else if (entry.is_regular_file(ec) && should_watch_file(entry_path)) {
+                PathId id = paths.intern(entry_path);
+                if (!is_watched(id)) {
+                    add_change(id);
+                }
+            }
+        }
+    }
+}
+
+bool FileWatcher::start_inotify() {
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        std::cerr << "[WARNING] inotify is not available, falling back to polling." << std::endl;
+        return false;
+    }
+
+    for (const std::string& path : watch_paths_) {
+        std::error_code ec;
+        bool added = true;
+        if (std::filesystem::is_directory(path, ec)) {
+            added = add_recursive_watch(path);
+        } else if (std::filesystem::is_regular_file(path, ec)) {
+            // Individual files are watched through their directory, which survives atomic saves
+            added = add_directory_watch(std::filesystem::path(path).parent_path().string(), false);
+        }
+        if (!added) {
+            std::cerr << "[WARNING] Could not watch " << path << " with inotify (" << std::strerror(errno)
+                      << "), falling back to polling." << std::endl;
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileWatcher::stop_inotify() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+#endif
+    inotify_fd_ = -1;
+    watched_dirs_.clear();
 }
 
+bool FileWatcher::add_directory_watch(const std::string& path, bool recursive) {
+#ifdef __linux__
+    int wd = inotify_add_watch(inotify_fd_, path.empty() ? "." : path.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        return false;
+    }
+
+    // The same directory may be reached through several watch paths
+    auto it = watched_dirs_.find(wd);
+    if (it == watched_dirs_.end()) {
+        watched_dirs_[wd] = {path, recursive, 0};
+    } else {
+        it->second.recursive = it->second.recursive || recursive;
+    }
+    return true;
+#else
+    (void)path;
+    (void)recursive;
+    return false;
+#endif
+}
+
+bool FileWatcher::add_recursive_watch(const std::string& path) {
+    if (!add_directory_watch(path, true)) {
+        return false;
+    }
+
+    try {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            if (entry.is_directory() && !add_directory_watch(entry.path().string(), true)) {
+                return false;
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "[ERROR] Failed to scan directory " << path << ": " << e.what() << std::endl;
+    }
+    return true;
+}
+
+bool FileWatcher::read_inotify_events(int timeout_ms) {
+#ifdef __linux__
+    pollfd descriptor = {inotify_fd_, POLLIN, 0};
+    if (::poll(&descriptor, 1, timeout_ms) <= 0) {
+        return false; // Timeout, or interrupted by a signal
+    }
+
+    PathTable& paths = PathTable::shared();
+    bool overflow = false;
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    while (true) {
+        ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN: queue drained
+        }
+
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+
+            auto it = watched_dirs_.find(event->wd);
+            if (it == watched_dirs_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watched_dirs_.erase(it);
+                continue;
+            }
+            if (event->len == 0) {
+                continue; // Event about the watched directory itself
+            }
+
+            WatchedDirectory directory = it->second;
+            std::string path = join_path(directory.path, event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (!directory.recursive) {
+                    continue;
+                }
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    add_new_directory(path);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    remove_directory(path);
+                }
+                continue;
+            }
+
+            // Watched files are always source or header files
+            if (!should_watch_file(path)) {
+                continue;
+            }
+            PathId id = paths.intern(path);
+            if (directory.recursive || is_watched(id)) {
+                add_change(id);
+            }
+        }
+    }
+
+    // Events were lost; compare every watched file and re-add watches for directories created meanwhile
+    if (overflow) {
+        std::cerr << "[WARNING] inotify event queue overflowed, rescanning watched files." << std::endl;
+        std::vector<PathId> changes = changed_files_;
+        has_changes();
+        changes.insert(changes.end(), changed_files_.begin(), changed_files_.end());
+        changed_files_ = changes;
+        for (const std::string& path : watch_paths_) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(path, ec)) {
+                add_recursive_watch(path);
+            }
+        }
+    }
+
+    std::sort(changed_files_.begin(), changed_files_.end());
+    changed_files_.erase(std::unique(changed_files_.begin(), changed_files_.end()), changed_files_.end());
+    return !changed_files_.empty();
+#else
+    (void)timeout_ms;
+    return false;
+#endif
+}
+
+void FileWatcher::add_new_directory(const std::string& path) {
+    if (!add_recursive_watch(path)) {
+        std::cerr << "[WARNING] Could not watch new directory " << path << std::endl;
+    }
+
+    // Files may have been created before the watch was in place
+    try {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file() && should_watch_file(entry.path().string())) {
+                add_change(PathTable::shared().intern(entry.path().string()));
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "[ERROR] Failed to scan directory " << path << ": " << e.what() << std::endl;
+    }
+}
+
+void FileWatcher::remove_directory(const std::string& path) {
+    PathTable& paths = PathTable::shared();
+    std::string prefix = path + "/";
+    for (const WatchedFile& file : files_) {
+        if (paths.str(file.path).compare(0, prefix.size(), prefix) == 0) {
+            changed_files_.push_back(file.path);
+        }
+    }
+
+#ifdef __linux__
+    // A directory moved elsewhere keeps its watches, which would report stale paths
+    for (auto it = watched_dirs_.begin(); it != watched_dirs_.end();) {
+        if (it->second.path == path || it->second.path.compare(0, prefix.size(), prefix) == 0) {
+            inotify_rm_watch(inotify_fd_, it->first);
+            it = watched_dirs_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#endif
+}
@@ -5,20 +5,53 @@
 
 #include <string>
 #include <vector>
-#include <map>
 #include <chrono>
 #include <filesystem>
+#include <unordered_map>
+#include "FileSystemUtils.h"
+#include "PathTable.h"
+
+/**
+ * @brief How a FileWatcher detects changes
+ */
+enum class WatcherBackend {
+    AUTO,  // inotify where available, polling otherwise
+    POLL   // Always poll (for file systems without change notifications, e.g. NFS)
+};
 
 /**
  * @brief Class for monitoring file changes in the file system
+ *
+ * On Linux, changes are reported by inotify as soon as they happen; watches are added
+ * for every directory below the watched directories (and for the directories of
+ * individually watched files) and follow directories that are created or renamed.
+ * Elsewhere, or if inotify is unavailable, the watched files are polled: one stat per
+ * file, spread over several threads for large watch sets, while new files are found by
+ * listing only the watched directories whose modification time changed.
+ *
+ * A file whose stamp changed but whose size did not is hashed, and only reported if
+ * its content differs, so touching files or rewriting them unchanged (e.g. checking
+ * out an identical branch) does not trigger rebuilds.
+ *
+ * wait_for_changes() coalesces changes into one batch until no file changed for a
+ * quiet period, so a save-all or a branch switch is reported once.
  */
 class FileWatcher {
 public:
     /**
      * @brief Constructor
      * @param watch_paths Paths to watch (files or directories)
+     * @param backend How changes are detected
+     */
+    explicit FileWatcher(const std::vector<std::string>& watch_paths, WatcherBackend backend = WatcherBackend::AUTO);
+
+    /**
+     * @brief Destructor, releases the inotify instance
      */
-    explicit FileWatcher(const std::vector<std::string>& watch_paths);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
 
     /**
      * @brief Initializes the file watcher and records initial state
@@ -27,11 +60,47 @@ public:
     bool initialize();
 
     /**
-     * @brief Checks if any watched files have been modified
+     * @brief Replaces the watched paths and rescans them
+     *
+     * Files that stay watched keep their recorded state, so they are not fingerprinted again.
+     * @param watch_paths Paths to watch (files or directories)
+     * @return true if there are files to watch
+     */
+    bool set_watch_paths(const std::vector<std::string>& watch_paths);
+
+    /**
+     * @brief Checks if any watched files have been modified by polling all of them
      * @return true if changes were detected
      */
     bool has_changes();
 
+    /**
+     * @brief Waits until watched files change or the timeout expires
+     *
+     * With inotify this returns as soon as a change arrives; otherwise it sleeps for
+     * the timeout and then polls. Once a change is seen, further changes are collected
+     * until none arrive for the debounce period or the maximum wait is reached. The batch
+     * is deduplicated and reduced to the files whose content differs from before it
+     * started: temporary files that came and went are dropped, and files deleted and
+     * written back unchanged are not reported. The new state of the files is recorded.
+     * @param timeout_ms Maximum time to wait for the first change in milliseconds
+     * @return true if changes were detected (see get_changed_files)
+     */
+    bool wait_for_changes(int timeout_ms);
+
+    /**
+     * @brief Sets how changes are coalesced by wait_for_changes
+     * @param debounce_ms Quiet period that ends a batch (0 to report changes as soon as they are seen)
+     * @param max_wait_ms Maximum time a batch is held back after its first change
+     */
+    void set_debounce(int debounce_ms, int max_wait_ms);
+
+    /**
+     * @brief Checks if changes are reported by the operating system instead of polling
+     * @return true if the inotify backend is active
+     */
+    bool is_event_based() const;
+
     /**
      * @brief Gets list of files that have changed since last check
      * @return Vector of changed file paths
@@ -39,7 +108,7 @@ public:
     std::vector<std::string> get_changed_files();
 
     /**
-     * @brief Updates the internal state after processing changes
+     * @brief Records the current state of the changed files, so they are not reported again
      */
     void update_state();
 
@@ -49,10 +118,101 @@ public:
      */
     std::vector<std::string> get_watched_files() const;
 
+    /**
+     * @brief Gets the number of files currently being watched
+     */
+    size_t get_watched_count() const;
+
+    /**
+     * @brief Gets when the first change of the last batch was seen
+     */
+    std::chrono::steady_clock::time_point get_batch_start() const;
+
 private:
+    /**
+     * @brief A watched file and its last known state
+     */
+    struct WatchedFile {
+        PathId path;
+        FileStamp stamp;
+        uint64_t hash;      // Content fingerprint
+    };
+
+    /**
+     * @brief A directory with an inotify watch
+     */
+    struct WatchedDirectory {
+        std::string path;   // Empty for the current directory of individually watched files
+        bool recursive;     // New files and subdirectories are watched as well
+        long long mtime;    // Last known modification time (polling only)
+    };
+
+    static constexpr uint32_t NOT_WATCHED = 0xFFFFFFFFu;
+
+    int inotify_fd_ = -1;
+    std::unordered_map<int, WatchedDirectory> watched_dirs_;  // inotify watch descriptor -> directory
+
+    WatcherBackend backend_;
+    int debounce_ms_ = 100;
+    int max_wait_ms_ = 2000;
+    std::chrono::steady_clock::time_point batch_start_;
     std::vector<std::string> watch_paths_;
-    std::map<std::string, std::filesystem::file_time_type> file_timestamps_;
-    std::vector<std::string> changed_files_;
+    std::vector<WatchedFile> files_;        // Flat list of watched files
+    std::vector<WatchedDirectory> directories_;                 // Directories polled for new files
+    std::unordered_map<std::string, uint32_t> directory_index_;  // Path -> position in directories_
+    std::vector<uint32_t> file_index_;      // PathId -> position in files_, or NOT_WATCHED
+    std::vector<PathId> changed_files_;
+
+    /**
+     * @brief Starts watching a file or updates its state
+     * @param path Id of the file path
+     * @param stamp Current state of the file
+     * @param hash Current content fingerprint
+     */
+    void set_file_stamp(PathId path, const FileStamp& stamp, uint64_t hash);
+
+    /**
+     * @brief Checks whether a watched file was modified or deleted since it was recorded
+     *
+     * Files with a new stamp but identical content get the new stamp recorded and are not reported.
+     * @param file The watched file
+     * @param path Path of the file
+     * @return true if the content changed or the file is gone
+     */
+    static bool content_changed(WatchedFile& file, const std::string& path);
+
+    /**
+     * @brief Computes the content fingerprint of every watched file
+     * @param previous Files watched before, whose fingerprints are reused while their stamp is unchanged
+     * @param previous_index Positions in previous, indexed by PathId
+     */
+    void fingerprint_files(const std::vector<WatchedFile>& previous, const std::vector<uint32_t>& previous_index);
+
+    /**
+     * @brief Waits for one round of changes (inotify events or one poll)
+     * @param timeout_ms Maximum time to wait in milliseconds
+     * @return true if changes were detected
+     */
+    bool detect_changes(int timeout_ms);
+
+    /**
+     * @brief Stops watching a file
+     * @param path Id of the file path
+     */
+    void remove_file(PathId path);
+
+    /**
+     * @brief Checks whether a file is being watched
+     * @param path Id of the file path
+     * @return true if the file is in the watch list
+     */
+    bool is_watched(PathId path) const;
+
+    /**
+     * @brief Records a change, unless a watched file still has the same content
+     * @param path Id of the changed file
+     */
+    void add_change(PathId path);
 
     /**
      * @brief Recursively scans directory and adds files to watch list
@@ -60,6 +220,69 @@ private:
      */
     void scan_directory(const std::string& path);
 
+    /**
+     * @brief Starts polling a directory for new files
+     * @param path Directory path
+     * @param mtime Current modification time, or -1 to list it on the next poll
+     * @return true if the directory was not tracked yet
+     */
+    bool track_directory(const std::string& path, long long mtime);
+
+    /**
+     * @brief Stats every watched file and records the modified and deleted ones
+     */
+    void poll_files();
+
+    /**
+     * @brief Lists the tracked directories whose modification time changed and records new files
+     */
+    void poll_directories();
+
+    /**
+     * @brief Sets up inotify watches for all watch paths
+     * @return true if every directory could be watched
+     */
+    bool start_inotify();
+
+    /**
+     * @brief Releases the inotify instance and all of its watches
+     */
+    void stop_inotify();
+
+    /**
+     * @brief Adds an inotify watch for a directory
+     * @param path Directory to watch
+     * @param recursive Whether new files and subdirectories in it are watched
+     * @return true if the watch was added
+     */
+    bool add_directory_watch(const std::string& path, bool recursive);
+
+    /**
+     * @brief Adds inotify watches for a directory and all of its subdirectories
+     * @param path Directory to watch
+     * @return true if every watch was added
+     */
+    bool add_recursive_watch(const std::string& path);
+
+    /**
+     * @brief Waits for inotify events and translates them into changed files
+     * @param timeout_ms Maximum time to wait in milliseconds
+     * @return true if changes were detected
+     */
+    bool read_inotify_events(int timeout_ms);
+
+    /**
+     * @brief Reports the watchable files of a directory that appeared (created or moved in)
+     * @param path The new directory
+     */
+    void add_new_directory(const std::string& path);
+
+    /**
+     * @brief Reports every watched file below a directory that disappeared
+     * @param path The removed directory
+     */
+    void remove_directory(const std::string& path);
+
     /**
      * @brief Checks if a file should be watched (C++ source/header files)
      * @param path File path to check
@@ -67,12 +290,6 @@ private:
      */
     bool should_watch_file(const std::string& path) const;
 
-    /**
-     * @brief Gets the last modification time of a file
-     * @param path File path
-     * @return File modification time
-     */
-    std::filesystem::file_time_type get_file_time(const std::string& path) const;
 };
 
 #endif // FILE_WATCHER_H
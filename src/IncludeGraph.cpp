@@ -0,0 +1,320 @@
+#include "IncludeGraph.h"
+#include "ContentHash.h"
+#include "core.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+std::unordered_map<PathId, IncludeScanEntry> IncludeGraph::scan_cache_;
+bool IncludeGraph::cache_loaded_ = false;
+bool IncludeGraph::cache_dirty_ = false;
+std::atomic<uint64_t> IncludeGraph::scan_hits_(0);
+std::atomic<uint64_t> IncludeGraph::scan_misses_(0);
+
+namespace {
+    const char* INCLUDE_CACHE_FILE = BODGE_CACHE_DIR "/include_scan.cache";
+    const char* INCLUDE_CACHE_HEADER = "BODGE_INCLUDE_CACHE 2";
+}
+
+IncludeGraph::IncludeGraph(const std::vector<std::string>& include_dirs) : epoch_(0) {
+    for (const std::string& dir : include_dirs) {
+        include_dirs_.push_back(FileSystemUtils::normalize_path(dir));
+    }
+    load_cache();
+}
+
+std::vector<PathId> IncludeGraph::get_direct_includes(const std::string& file) {
+    Row row = resolve_row(PathTable::shared().intern(FileSystemUtils::normalize_path(file)));
+    return std::vector<PathId>(edges_.begin() + row.offset, edges_.begin() + row.offset + row.count);
+}
+
+std::vector<PathId> IncludeGraph::get_transitive_includes(const std::string& file) {
+    std::vector<PathId> includes;
+    walk(PathTable::shared().intern(FileSystemUtils::normalize_path(file)), [&](PathId include) {
+        includes.push_back(include);
+        return true;
+    });
+    return includes;
+}
+
+std::vector<std::string> IncludeGraph::get_affected_sources(const std::vector<std::string>& changed_files,
+                                                            const std::vector<std::string>& sources) {
+    PathTable& paths = PathTable::shared();
+    std::vector<bool> changed;
+    for (const std::string& file : changed_files) {
+        PathId id = paths.intern(FileSystemUtils::normalize_path(file));
+        if (id >= changed.size()) {
+            changed.resize(id + 1, false);
+        }
+        changed[id] = true;
+    }
+
+    auto is_changed = [&](PathId id) {
+        return id < changed.size() && changed[id];
+    };
+
+    std::vector<std::string> affected;
+    for (const std::string& source : sources) {
+        PathId source_id = paths.intern(FileSystemUtils::normalize_path(source));
+        bool hit = is_changed(source_id);
+
+        if (!hit) {
+            walk(source_id, [&](PathId include) {
+                hit = is_changed(include);
+                return !hit;
+            });
+        }
+
+        if (hit) {
+            affected.push_back(source);
+        }
+    }
+
+    return affected;
+}
+
+IncludeGraph::Row IncludeGraph::resolve_row(PathId file) {
+    if (file >= rows_.size()) {
+        rows_.resize(PathTable::shared().size(), {0, UNRESOLVED});
+    }
+    if (rows_[file].count != UNRESOLVED) {
+        return rows_[file];
+    }
+
+    // Resolve everything first: resolving may intern new paths but never touches edges_
+    std::vector<PathId> resolved;
+    std::string file_path = PathTable::shared().str(file);
+    std::string including_dir = std::filesystem::path(file_path).parent_path().string();
+    for (const IncludeDirective& directive : scan_file(file)) {
+        std::string path = resolve(directive, including_dir);
+        if (!path.empty()) {
+            resolved.push_back(PathTable::shared().intern(path));
+        }
+    }
+
+    Row row = {static_cast<uint32_t>(edges_.size()), static_cast<uint32_t>(resolved.size())};
+    edges_.insert(edges_.end(), resolved.begin(), resolved.end());
+    rows_[file] = row;
+    return row;
+}
+
+template<typename Visitor>
+void IncludeGraph::walk(PathId file, Visitor visitor) {
+    // A fresh epoch marks all files as unvisited without clearing the array
+    if (++epoch_ == 0) {
+        std::fill(visited_.begin(), visited_.end(), 0);
+        epoch_ = 1;
+    }
+
+    std::vector<PathId> pending = {file};
+    if (visited_.size() <= file) {
+        visited_.resize(PathTable::shared().size(), 0);
+    }
+    visited_[file] = epoch_;
+
+    while (!pending.empty()) {
+        PathId current = pending.back();
+        pending.pop_back();
+
+        Row row = resolve_row(current);
+        if (visited_.size() < PathTable::shared().size()) {
+            visited_.resize(PathTable::shared().size(), 0);
+        }
+
+        for (uint32_t i = row.offset; i < row.offset + row.count; ++i) {
+            PathId include = edges_[i];
+            if (visited_[include] == epoch_) {
+                continue;
+            }
+            visited_[include] = epoch_;
+            if (!visitor(include)) {
+                return;
+            }
+            pending.push_back(include);
+        }
+    }
+}
+
+const std::vector<IncludeDirective>& IncludeGraph::scan_file(PathId file) {
+    load_cache();
+
+    std::string path = PathTable::shared().str(file);
+    FileStamp stamp;
+    if (!FileSystemUtils::get_file_stamp(path, stamp)) {
+        static const std::vector<IncludeDirective> no_includes;
+        return no_includes;
+    }
+
+    auto it = scan_cache_.find(file);
+    if (it != scan_cache_.end() && it->second.stamp == stamp) {
+        ++scan_hits_;
+        return it->second.includes;
+    }
+
+    ++scan_misses_;
+    std::ifstream file_input(path, std::ios::binary);
+    std::stringstream content;
+    content << file_input.rdbuf();
+
+    IncludeScanEntry& entry = scan_cache_[file];
+    entry.stamp = stamp;
+    entry.includes = extract_includes(content.str());
+    ContentHash::hash_tokens(content.str(), entry.token_hash, entry.line_hash);
+    cache_dirty_ = true;
+    return entry.includes;
+}
+
+bool IncludeGraph::tokens_changed(const std::string& file, bool line_sensitive) {
+    load_cache();
+    PathId id = PathTable::shared().intern(FileSystemUtils::normalize_path(file));
+    auto it = scan_cache_.find(id);
+    if (it == scan_cache_.end()) {
+        scan_file(id);
+        return true;
+    }
+    FileStamp previous_stamp = it->second.stamp;
+    uint64_t previous_hash = line_sensitive ? it->second.line_hash : it->second.token_hash;
+
+    // A file that was deleted, or already scanned after it changed, cannot be compared
+    scan_file(id);
+    const IncludeScanEntry& entry = scan_cache_[id];
+    if (entry.stamp == previous_stamp) {
+        return true;
+    }
+    return (line_sensitive ? entry.line_hash : entry.token_hash) != previous_hash;
+}
+
+std::vector<IncludeDirective> IncludeGraph::extract_includes(const std::string& content) {
+    std::vector<IncludeDirective> includes;
+    std::istringstream input(content);
+
+    std::string line;
+    while (std::getline(input, line)) {
+        // Match: optional whitespace, '#', optional whitespace, "include", then "..." or <...>
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#') {
+            continue;
+        }
+
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+            continue;
+        }
+
+        pos = line.find_first_not_of(" \t", pos + 7);
+        if (pos == std::string::npos || (line[pos] != '"' && line[pos] != '<')) {
+            continue;
+        }
+
+        char closing = line[pos] == '"' ? '"' : '>';
+        size_t end = line.find(closing, pos + 1);
+        if (end == std::string::npos || end == pos + 1) {
+            continue;
+        }
+
+        includes.push_back({line.substr(pos + 1, end - pos - 1), closing == '>'});
+    }
+
+    return includes;
+}
+
+std::string IncludeGraph::resolve(const IncludeDirective& directive, const std::string& including_dir) const {
+    // Quoted includes are searched next to the including file first
+    if (!directive.angled) {
+        std::filesystem::path candidate = std::filesystem::path(including_dir) / directive.path;
+        if (FileSystemUtils::file_exists(candidate.string())) {
+            return FileSystemUtils::normalize_path(candidate.string());
+        }
+    }
+
+    for (const std::string& dir : include_dirs_) {
+        std::filesystem::path candidate = std::filesystem::path(dir) / directive.path;
+        if (FileSystemUtils::file_exists(candidate.string())) {
+            return FileSystemUtils::normalize_path(candidate.string());
+        }
+    }
+
+    return "";
+}
+
+void IncludeGraph::load_cache() {
+    if (cache_loaded_) {
+        return;
+    }
+    cache_loaded_ = true;
+
+    std::ifstream input(INCLUDE_CACHE_FILE);
+    if (!input.is_open()) {
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(input, line) || line != INCLUDE_CACHE_HEADER) {
+        return; // Unknown format, start with an empty cache
+    }
+
+    // Format:
+    //   F <mtime> <size> <inode> <token hash> <line hash> <include count> <path>
+    //   I <q|a> <include>
+    IncludeScanEntry* current = nullptr;
+    while (std::getline(input, line)) {
+        if (line.size() < 2) {
+            continue;
+        }
+
+        std::istringstream fields(line.substr(2));
+        if (line[0] == 'F') {
+            IncludeScanEntry entry;
+            size_t count = 0;
+            std::string path;
+            fields >> entry.stamp.mtime >> entry.stamp.size >> entry.stamp.inode >> entry.token_hash >> entry.line_hash >> count;
+            fields.get();
+            std::getline(fields, path);
+            if (!fields.fail() && !path.empty()) {
+                entry.includes.reserve(count);
+                current = &(scan_cache_[PathTable::shared().intern(path)] = entry);
+            } else {
+                current = nullptr;
+            }
+        } else if (line[0] == 'I' && current != nullptr && line.size() > 4) {
+            current->includes.push_back({line.substr(4), line[2] == 'a'});
+        }
+    }
+}
+
+void IncludeGraph::get_scan_stats(uint64_t& hits, uint64_t& misses) {
+    hits = scan_hits_;
+    misses = scan_misses_;
+}
+
+void IncludeGraph::save_cache() {
+    if (!cache_dirty_) {
+        return;
+    }
+
+    try {
+        std::filesystem::create_directories(BODGE_CACHE_DIR);
+    } catch (const std::filesystem::filesystem_error& e) {
+        std::cerr << "[WARNING] Could not create cache directory: " << e.what() << std::endl;
+        return;
+    }
+
+    std::ofstream output(INCLUDE_CACHE_FILE, std::ios::out | std::ios::trunc);
+    if (!output.is_open()) {
+        return;
+    }
+
+    output << INCLUDE_CACHE_HEADER << "\n";
+    for (const auto& [path, entry] : scan_cache_) {
+        output << "F " << entry.stamp.mtime << " " << entry.stamp.size << " " << entry.stamp.inode << " "
+               << entry.token_hash << " " << entry.line_hash << " " << entry.includes.size() << " "
+               << PathTable::shared().get(path) << "\n";
+        for (const IncludeDirective& include : entry.includes) {
+            output << "I " << (include.angled ? 'a' : 'q') << " " << include.path << "\n";
+        }
+    }
+
+    cache_dirty_ = false;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef INCLUDE_GRAPH_H
+#define INCLUDE_GRAPH_H
+
+#include "FileSystemUtils.h"
+#include "PathTable.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * @brief A single #include directive as written in a source file
+ */
+struct IncludeDirective {
+    std::string path;   // Path between the quotes or angle brackets
+    bool angled;        // true for <...>, false for "..."
+};
+
+/**
+ * @brief Cached result of scanning one file for #include directives
+ */
+struct IncludeScanEntry {
+    FileStamp stamp;
+    std::vector<IncludeDirective> includes;
+    uint64_t token_hash = 0;    // Token stream without comments and formatting (see ContentHash::hash_tokens)
+    uint64_t line_hash = 0;     // Token stream including the line of every token
+};
+
+/**
+ * @brief Include graph that resolves #include directives against include paths
+ *
+ * Quoted includes are looked up relative to the including file first and then in
+ * the include directories, angled includes only in the include directories. Headers
+ * that cannot be resolved (system headers) are not part of the graph. Scan results
+ * are shared between all graphs and persisted in the bodge cache directory, keyed
+ * by the file's modification time, size and inode.
+ */
+class IncludeGraph {
+public:
+    /**
+     * @brief Constructor
+     * @param include_dirs Include directories used to resolve includes, in search order
+     */
+    explicit IncludeGraph(const std::vector<std::string>& include_dirs = {});
+
+    /**
+     * @brief Gets the resolved files directly included by a file
+     * @param file Path of the including file
+     * @return Ids (in the shared PathTable) of the included files that exist on disk
+     */
+    std::vector<PathId> get_direct_includes(const std::string& file);
+
+    /**
+     * @brief Gets all files reachable from a file through #include directives
+     * @param file Path of the including file
+     * @return Ids (in the shared PathTable) of all transitively included files
+     */
+    std::vector<PathId> get_transitive_includes(const std::string& file);
+
+    /**
+     * @brief Determines which translation units are affected by a set of changed files
+     * @param changed_files Paths of the files that changed
+     * @param sources Translation units to check
+     * @return Sources that are changed themselves or transitively include a changed file
+     */
+    std::vector<std::string> get_affected_sources(const std::vector<std::string>& changed_files,
+                                                  const std::vector<std::string>& sources);
+
+    /**
+     * @brief Checks if the tokens of a file changed since it was last scanned, and scans it again
+     *
+     * By default tokens that only moved to other lines are no change, which trades the accuracy
+     * of __LINE__ and of debug line information in dependent objects for fewer rebuilds.
+     * @param file Path of the file
+     * @param line_sensitive true to also count tokens that moved to another line as a change
+     * @return false only if the file was scanned before and just its comments or formatting changed
+     */
+    static bool tokens_changed(const std::string& file, bool line_sensitive);
+
+    /**
+     * @brief Loads the scan cache from the bodge cache directory (called automatically)
+     */
+    static void load_cache();
+
+    /**
+     * @brief Writes the scan cache to the bodge cache directory if it changed
+     */
+    static void save_cache();
+
+    /**
+     * @brief Gets how often a file scan was answered from the scan cache
+     * @param hits Receives the number of scans served from the cache
+     * @param misses Receives the number of files that were read
+     */
+    static void get_scan_stats(uint64_t& hits, uint64_t& misses);
+
+private:
+    /**
+     * @brief Location of a file's resolved includes in edges_
+     */
+    struct Row {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    static constexpr uint32_t UNRESOLVED = 0xFFFFFFFFu;
+
+    std::vector<std::string> include_dirs_;
+    std::vector<Row> rows_;            // Indexed by PathId
+    std::vector<PathId> edges_;        // Append-only CSR edge array, one contiguous row per file
+    std::vector<uint32_t> visited_;    // Indexed by PathId, holds the epoch of the last visit
+    uint32_t epoch_;
+
+    static std::unordered_map<PathId, IncludeScanEntry> scan_cache_;
+    static bool cache_loaded_;
+    static bool cache_dirty_;
+    static std::atomic<uint64_t> scan_hits_;
+    static std::atomic<uint64_t> scan_misses_;
+
+    /**
+     * @brief Resolves the direct includes of a file into its row of edges_
+     * @param file Id of the normalized file path
+     * @return Row of the file's resolved includes
+     */
+    Row resolve_row(PathId file);
+
+    /**
+     * @brief Walks the graph from a file, calling a visitor for every reachable file
+     * @param file Id of the start file
+     * @param visitor Returns false to stop the walk early
+     */
+    template<typename Visitor>
+    void walk(PathId file, Visitor visitor);
+
+    /**
+     * @brief Returns the include directives of a file, rescanning only if it changed
+     * @param file Id of the normalized file path
+     * @return Include directives found in the file
+     */
+    static const std::vector<IncludeDirective>& scan_file(PathId file);
+
+    /**
+     * @brief Extracts all #include directives from the text of a file
+     * @param content Text of the file
+     * @return Include directives in order of appearance
+     */
+    static std::vector<IncludeDirective> extract_includes(const std::string& content);
+
+    /**
+     * @brief Resolves an include directive to a file on disk
+     * @param directive The directive to resolve
+     * @param including_dir Directory of the including file
+     * @return Normalized path of the included file, or empty if not found
+     */
+    std::string resolve(const IncludeDirective& directive, const std::string& including_dir) const;
+};
+
+#endif // INCLUDE_GRAPH_H
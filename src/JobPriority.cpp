@@ -0,0 +1,167 @@
+#include "JobPriority.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    const char* CGROUP_ROOT = "/sys/fs/cgroup";
+    const int IOPRIO_WHO_PROCESS = 1;
+    const int IOPRIO_CLASS_BE = 2;
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_CLASS_SHIFT = 13;
+
+    // Control files report errors on write, which std::ofstream would hide until it is closed
+    // Only calls async-signal-safe functions, so apply() can use it between fork and exec
+    bool write_control_file(const std::string& path, const char* value) {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        size_t size = std::strlen(value);
+        bool written = write(fd, value, size) == static_cast<ssize_t>(size);
+        close(fd);
+        return written;
+    }
+
+    // Directory of the cgroup v2 group this process belongs to, empty without cgroup v2
+    std::string own_cgroup() {
+        std::ifstream file("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 3, "0::") == 0) {
+                return CGROUP_ROOT + line.substr(3);
+            }
+        }
+        return "";
+    }
+#endif
+}
+
+JobPriority::JobPriority(const BackgroundSettings& settings) : settings_(settings) {
+#ifndef _WIN32
+    niceness_ = std::min(getpriority(PRIO_PROCESS, 0) + settings_.nice, 19);
+#endif
+}
+
+JobPriority::~JobPriority() {
+#ifdef __linux__
+    // Background jobs have finished, so the group is empty and can be removed
+    if (!cgroup_.empty()) {
+        rmdir(cgroup_.c_str());
+    }
+#endif
+}
+
+bool JobPriority::setup(std::string& error) {
+    if (!settings_.uses_cgroup()) {
+        return true;
+    }
+#ifndef __linux__
+    error = "cgroups are only available on Linux";
+    return false;
+#else
+    std::string group = own_cgroup();
+    if (group.empty() || !std::filesystem::exists(group + "/cgroup.controllers")) {
+        error = "cgroup v2 is not available";
+        return false;
+    }
+
+    // Controllers can only be enabled for the groups below a group without processes of its own,
+    // so the daemon has to be alone in its group and moves into a group below it
+    std::ifstream procs(group + "/cgroup.procs");
+    std::string pid;
+    while (std::getline(procs, pid)) {
+        if (pid != std::to_string(getpid())) {
+            error = "other processes share the daemon's cgroup " + group +
+                    "; start the daemon in a group of its own, e.g. with systemd-run --user --scope -p Delegate=yes";
+            return false;
+        }
+    }
+
+    std::ifstream controllers_file(group + "/cgroup.controllers");
+    std::set<std::string> controllers;
+    std::string controller;
+    while (controllers_file >> controller) {
+        controllers.insert(controller);
+    }
+    std::string enable;
+    if (settings_.cpu_weight > 0) {
+        if (controllers.count("cpu") == 0) {
+            error = "the cpu controller is not available in " + group;
+            return false;
+        }
+        enable += "+cpu ";
+    }
+    if (!settings_.memory_high.empty()) {
+        if (controllers.count("memory") == 0) {
+            error = "the memory controller is not available in " + group;
+            return false;
+        }
+        enable += "+memory ";
+    }
+
+    std::error_code ec;
+    std::string daemon_group = group + "/bodge-daemon";
+    std::string background_group = group + "/bodge-background";
+    std::filesystem::create_directory(daemon_group, ec);
+    if (ec || !write_control_file(daemon_group + "/cgroup.procs", std::to_string(getpid()).c_str())) {
+        error = "cannot move the daemon into " + daemon_group + " (is the cgroup delegated to you?)";
+        return false;
+    }
+    if (!write_control_file(group + "/cgroup.subtree_control", enable.c_str())) {
+        error = "cannot enable the controllers in " + group;
+        return false;
+    }
+    std::filesystem::create_directory(background_group, ec);
+    if (ec) {
+        error = "cannot create " + background_group;
+        return false;
+    }
+    if (settings_.cpu_weight > 0 &&
+        !write_control_file(background_group + "/cpu.weight", std::to_string(settings_.cpu_weight).c_str())) {
+        error = "cannot set cpu.weight of " + background_group;
+        return false;
+    }
+    if (!settings_.memory_high.empty() && !write_control_file(background_group + "/memory.high", settings_.memory_high.c_str())) {
+        error = "cannot set memory.high of " + background_group;
+        return false;
+    }
+    cgroup_ = background_group;
+    cgroup_procs_ = background_group + "/cgroup.procs";
+    return true;
+#endif
+}
+
+void JobPriority::apply() const {
+#ifndef _WIN32
+    // The job is a single thread between fork and exec, so its priorities are the process's
+    if (settings_.nice > 0) {
+        setpriority(PRIO_PROCESS, 0, niceness_);
+    }
+#ifdef __linux__
+    if (settings_.io_level >= 0) {
+        int priority = settings_.io_level == BackgroundSettings::IO_IDLE
+                           ? IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT
+                           : (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | settings_.io_level;
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, priority);
+    }
+    if (!cgroup_procs_.empty()) {
+        // "0" moves the writing process itself
+        write_control_file(cgroup_procs_, "0");
+    }
+#endif
+#endif
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef JOB_PRIORITY_H
+#define JOB_PRIORITY_H
+
+#include <string>
+
+/**
+ * @brief Resource settings for build jobs that nobody is waiting for
+ */
+struct BackgroundSettings {
+    static const int IO_IDLE = 8;   // io_level of the idle I/O class
+
+    int nice = 0;                   // Added to the niceness of background jobs (0: unchanged)
+    int io_level = -1;              // Best-effort I/O priority 0-7, IO_IDLE, or -1 to leave it unchanged
+    int cpu_weight = 0;             // cpu.weight of the background cgroup (0: not limited)
+    std::string memory_high;        // memory.high of the background cgroup, e.g. "4G" (empty: not limited)
+
+    /**
+     * @brief Checks if background jobs are run in a cgroup of their own
+     */
+    bool uses_cgroup() const { return cpu_weight > 0 || !memory_high.empty(); }
+};
+
+/**
+ * @brief Lowers the CPU and I/O priority of background build jobs
+ *
+ * Applied to a job's shell before it executes the command, so the shell and the compiler
+ * processes it starts run with the settings from their first instruction. With a CPU weight or memory limit, background jobs are moved into
+ * the cgroup v2 group "bodge-background" below the daemon's own group. That
+ * requires the daemon to be the only process in its group (e.g. started with
+ * "systemd-run --user --scope -p Delegate=yes"); the daemon itself moves into the group
+ * "bodge-daemon" next to it. Priorities are only lowered, so jobs started in the background
+ * keep their priority until they finish. Only available on Linux, except for the niceness.
+ */
+class JobPriority {
+public:
+    explicit JobPriority(const BackgroundSettings& settings);
+
+    /**
+     * @brief Removes the background cgroup
+     */
+    ~JobPriority();
+    JobPriority(const JobPriority&) = delete;
+    JobPriority& operator=(const JobPriority&) = delete;
+
+    /**
+     * @brief Creates the background cgroup if a CPU weight or memory limit is set
+     * @param error Receives the reason if the cgroup could not be set up
+     * @return true if background jobs can be moved into the cgroup, or no cgroup is used
+     */
+    bool setup(std::string& error);
+
+    /**
+     * @brief Applies the background settings to the calling process
+     *
+     * Called in a job's child process between fork and exec, so it only uses
+     * async-signal-safe functions and allocates no memory.
+     */
+    void apply() const;
+
+private:
+    BackgroundSettings settings_;
+    int niceness_ = 0;          // Niceness of background jobs
+    std::string cgroup_;        // Directory of the background cgroup, empty if none is used
+    std::string cgroup_procs_;  // cgroup.procs of the background cgroup, empty if none is used
+};
+
+#endif // JOB_PRIORITY_H
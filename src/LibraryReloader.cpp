@@ -0,0 +1,70 @@
+#include "LibraryReloader.h"
+#include "DaemonSocket.h"
+#include "core.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    const char* RELOAD_DIR = BODGE_CACHE_DIR "/reload";
+    const size_t KEPT_COPIES = 2;  // A host may still be loading the previous copy
+}
+
+LibraryReloader::~LibraryReloader() {
+    for (const Host& host : hosts_) {
+        DaemonSocket::close_connection(host.connection);
+    }
+}
+
+bool LibraryReloader::subscribe(int connection, const BuildAction& action) {
+    if (!DaemonSocket::write_all(connection, "ok\n")) {
+        DaemonSocket::close_connection(connection);
+        return false;
+    }
+    hosts_.push_back({connection, action.target, action.platform.to_string()});
+    return true;
+}
+
+void LibraryReloader::publish(const BuildAction& action) {
+    std::string platform = action.platform.to_string();
+    auto subscribed = [&](const Host& host) { return host.target == action.target && host.platform == platform; };
+    if (action.type != BuildType::SHARED_LIBRARY || action.outputs.empty() ||
+        std::none_of(hosts_.begin(), hosts_.end(), subscribed)) {
+        return;
+    }
+
+    // The version number makes the name unique, so the copy is loaded instead of the cached old library
+    std::filesystem::path library(action.outputs.front());
+    std::filesystem::path copy = std::filesystem::path(RELOAD_DIR) /
+        (library.stem().string() + "." + std::to_string(++version_) + library.extension().string());
+    std::error_code ec;
+    std::filesystem::create_directories(RELOAD_DIR, ec);
+    std::filesystem::copy_file(library, copy, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec) {
+        std::cerr << "[WARNING] Failed to copy " << library.string() << " for live reload: " << ec.message() << std::endl;
+        return;
+    }
+    std::string path = std::filesystem::absolute(copy, ec).string();
+
+    std::vector<std::string>& copies = copies_[library.string()];
+    copies.push_back(copy.string());
+    while (copies.size() > KEPT_COPIES) {
+        std::filesystem::remove(copies.front(), ec);
+        copies.erase(copies.begin());
+    }
+
+    // Hosts that exited are dropped when the notification cannot be written
+    size_t notified = 0;
+    for (auto it = hosts_.begin(); it != hosts_.end();) {
+        if (!subscribed(*it)) {
+            ++it;
+        } else if (DaemonSocket::write_all(it->connection, "reload\t" + action.target + "\t" + path + "\n")) {
+            ++notified;
+            ++it;
+        } else {
+            DaemonSocket::close_connection(it->connection);
+            it = hosts_.erase(it);
+        }
+    }
+    std::cout << "[INFO] Live reload: sent " << copy.filename().string() << " to " << notified << " host(s)" << std::endl;
+}
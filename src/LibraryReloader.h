@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef LIBRARY_RELOADER_H
+#define LIBRARY_RELOADER_H
+
+#include "BuildPlan.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Notifies host processes when a shared library they loaded was rebuilt
+ *
+ * Hosts subscribe to a shared library target over the daemon's control socket (see
+ * include/bodge/live_reload.h) and keep the connection open. After the target is relinked,
+ * the library is copied to a new versioned file in .bodge_cache/reload, because a host
+ * cannot load a changed library again under the path it already loaded, and every
+ * subscribed host is sent the line "reload<TAB>target<TAB>absolute path of the copy".
+ * The two newest copies of each library are kept. Not available on Windows.
+ */
+class LibraryReloader {
+public:
+    LibraryReloader() = default;
+
+    /**
+     * @brief Closes the connections of all subscribed hosts
+     */
+    ~LibraryReloader();
+    LibraryReloader(const LibraryReloader&) = delete;
+    LibraryReloader& operator=(const LibraryReloader&) = delete;
+
+    /**
+     * @brief Subscribes a host to a shared library target
+     * @param connection Connection of the host; owned by the reloader from now on
+     * @param action Target action that builds the library
+     * @return false if the host has already disconnected
+     */
+    bool subscribe(int connection, const BuildAction& action);
+
+    /**
+     * @brief Sends a rebuilt library to the hosts subscribed to it
+     * @param action Target action that was built successfully
+     */
+    void publish(const BuildAction& action);
+
+private:
+    /**
+     * @brief Host process waiting for new versions of a library
+     */
+    struct Host {
+        int connection;
+        std::string target;
+        std::string platform;
+    };
+
+    std::vector<Host> hosts_;
+    std::map<std::string, std::vector<std::string>> copies_;  // By library, oldest first
+    unsigned version_ = 0;
+};
+
+#endif // LIBRARY_RELOADER_H
@@ -0,0 +1,112 @@
+#include "MetricsServer.h"
+#include "DaemonSocket.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const int ACCEPT_TIMEOUT_MS = 200;    // How quickly stop() is noticed
+    const int REQUEST_TIMEOUT_MS = 1000;  // Time a client gets to send its request
+    const size_t MAX_REQUEST_SIZE = 8192;
+}
+
+MetricsServer::MetricsServer(const DaemonMetrics& metrics) : metrics_(metrics) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const std::string& host, int port) {
+#ifdef _WIN32
+    (void)host;
+    (void)port;
+    return false;
+#else
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (fd_ >= 0 || inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        return false;
+    }
+
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    fcntl(fd_, F_SETFD, FD_CLOEXEC);
+    int reuse = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd_, 16) < 0) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    stopping_ = false;
+    thread_ = std::thread([this]() { serve(); });
+    return true;
+#endif
+}
+
+void MetricsServer::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+#endif
+    fd_ = -1;
+}
+
+void MetricsServer::serve() {
+#ifndef _WIN32
+    while (!stopping_) {
+        pollfd descriptor = {fd_, POLLIN, 0};
+        if (poll(&descriptor, 1, ACCEPT_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        int connection = accept(fd_, nullptr, nullptr);
+        if (connection >= 0) {
+            fcntl(connection, F_SETFD, FD_CLOEXEC);
+            handle(connection);
+            close(connection);
+        }
+    }
+#endif
+}
+
+void MetricsServer::handle(int connection) {
+#ifdef _WIN32
+    (void)connection;
+#else
+    // Only the request line matters; the headers are read up to the blank line that ends them
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+        pollfd descriptor = {connection, POLLIN, 0};
+        if (poll(&descriptor, 1, REQUEST_TIMEOUT_MS) <= 0 || !DaemonSocket::read_available(connection, request)) {
+            return;
+        }
+    }
+
+    std::string status = "404 Not Found";
+    std::string body = "Not found. Metrics are served at /metrics\n";
+    std::string content_type = "text/plain; charset=utf-8";
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) {
+        status = "200 OK";
+        body = metrics_.render();
+        content_type = "text/plain; version=0.0.4; charset=utf-8";
+    }
+    DaemonSocket::write_all(connection, "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                                            "\r\nContent-Length: " + std::to_string(body.size()) +
+                                            "\r\nConnection: close\r\n\r\n" + body);
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "DaemonMetrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Minimal HTTP endpoint that serves daemon metrics to Prometheus
+ *
+ * Answers "GET /metrics" on a TCP port from a thread of its own, so scrapes are answered
+ * while a rebuild runs. Every other request gets a 404. Not available on Windows.
+ */
+class MetricsServer {
+public:
+    /**
+     * @brief Constructor
+     * @param metrics Metrics to serve; must outlive the server
+     */
+    explicit MetricsServer(const DaemonMetrics& metrics);
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Starts listening
+     * @param host IPv4 address to listen on
+     * @param port TCP port
+     * @return true if the server is listening
+     */
+    bool start(const std::string& host, int port);
+
+    /**
+     * @brief Stops the server thread and closes the port
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Accepts and answers connections until stop() is called
+     */
+    void serve();
+
+    /**
+     * @brief Reads one request from a connection and answers it
+     */
+    void handle(int connection);
+
+    const DaemonMetrics& metrics_;
+    int fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+#endif // METRICS_SERVER_H
@@ -0,0 +1,374 @@
+#include "NinjaGenerator.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+
+namespace {
+    const char* NINJA_BUILD_DIR = BODGE_CACHE_DIR "/ninja";
+    const char* OBJECT_DIR = BODGE_CACHE_DIR "/obj";
+
+    bool is_plain_argument(const std::string& arg) {
+        if (arg.empty()) {
+            return false;
+        }
+        for (char c : arg) {
+            bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                         std::string("_-+=./:,@%").find(c) != std::string::npos;
+#ifdef _WIN32
+            plain = plain || c == '\\';
+#endif
+            if (!plain) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    std::string native_path(std::string path) {
+        std::replace(path.begin(), path.end(), '/', '\\');
+        return path;
+    }
+#endif
+}
+
+E_RESULT NinjaGenerator::generate(const ProjectConfig& config, const BuildPlan& plan, const std::vector<Platform>& platforms,
+                                  const std::vector<std::string>& config_files, const std::string& regenerate_command,
+                                  const std::string& filename) {
+    std::ofstream out(filename, std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "[ERROR] Failed to open '" << filename << "' for writing." << std::endl;
+        return S_FILE_OPERATION_FAILED;
+    }
+
+    out << "# Generated by bodge " << get_version() << " from the project configuration - do not edit.\n"
+        << "# Regenerate with: bodge generate ninja\n\n"
+        << "ninja_required_version = 1.5\n"
+        << "builddir = " << escape_value(NINJA_BUILD_DIR) << "\n\n";
+
+    out << "rule cxx\n"
+        << "  command = $compiler $flags -MD -MF $out.d -c $in -o $out\n"
+        << "  depfile = $out.d\n"
+        << "  deps = gcc\n"
+        << "  restat = 1\n"
+        << "  description = CXX $out\n\n"
+        << "rule link\n"
+        << "  command = $compiler $flags $in -o $out $ldflags\n"
+        << "  restat = 1\n"
+        << "  description = LINK $out\n\n"
+        << "rule archive\n"
+#ifdef _WIN32
+        << "  command = cmd /c \"if exist $out del /Q $out\" && ar rcs $out $in\n"
+#else
+        << "  command = rm -f $out && ar rcs $out $in\n"
+#endif
+        << "  description = AR $out\n\n"
+        << "rule generate\n"
+        << "  command = $cmd\n"
+        << "  restat = 1\n"
+        << "  description = GENERATE $name\n\n"
+        << "rule sequence\n"
+        << "  command = $cmd\n"
+        << "  pool = console\n"
+        << "  description = SEQUENCE $name\n\n"
+        << "rule regenerate\n"
+        << "  command = " << escape_value(regenerate_command) << "\n"
+        << "  generator = 1\n"
+        << "  description = Regenerating $out\n\n";
+
+    const std::vector<BuildAction>& actions = plan.actions();
+    std::set<std::string> outputs;                                  // Every path produced by a link edge
+    std::map<std::string, std::vector<std::string>> target_outputs;  // Phony aliases
+    std::vector<std::string> defaults;
+
+    for (uint32_t index = 0; index < actions.size(); ++index) {
+        const BuildAction& action = actions[index];
+        if (action.kind == ActionKind::TARGET &&
+            std::find(platforms.begin(), platforms.end(), action.platform) == platforms.end()) {
+            continue;
+        }
+        if (!action.is_valid()) {
+            std::cerr << "[WARNING] Skipping '" << action.target << "': " << action.error << std::endl;
+            continue;
+        }
+
+        // Generator rules: the command runs again when its inputs or the command change
+        if (action.kind == ActionKind::RULE) {
+            out << "# rule " << action.target << "\n"
+                << "build";
+            for (const std::string& output : action.outputs) {
+                out << " " << escape_path(output);
+            }
+            out << ": generate";
+            for (const std::string& input : action.inputs) {
+                out << " " << escape_path(input);
+            }
+            out << "\n"
+                << "  cmd = " << escape_value(action.command) << "\n"
+                << "  name = " << escape_value(action.target) << "\n";
+            if (!action.depfile.empty()) {
+                out << "  depfile = " << escape_value(action.depfile) << "\n"
+                    << "  deps = gcc\n";
+            }
+            out << "\n";
+            continue;
+        }
+
+        const std::string& output = action.outputs.front();
+        if (outputs.count(output) > 0) {
+            std::cerr << "[WARNING] Skipping target '" << action.target << "' for " << action.platform.to_string()
+                      << ": output '" << output << "' is already produced for another platform." << std::endl;
+            continue;
+        }
+        outputs.insert(output);
+
+        std::string flags_var = "flags_" + std::to_string(index);
+        out << "# " << action.target << " (" << action.platform.to_string() << ")\n"
+            << flags_var << " = " << escape_value(join_arguments(action.compile_flags)) << "\n";
+
+        // Generated headers must exist before any source of the target is compiled
+        std::string generated;
+        for (uint32_t dependency : action.deps) {
+            if (actions[dependency].kind == ActionKind::RULE) {
+                for (const std::string& rule_output : actions[dependency].outputs) {
+                    generated += " " + escape_path(rule_output);
+                }
+            }
+        }
+
+        // One compile edge per source file
+        std::vector<std::string> objects;
+        for (const std::string& source : action.inputs) {
+            objects.push_back(object_path(action, source));
+            out << "build " << escape_path(objects.back()) << ": cxx " << escape_path(source)
+                << (generated.empty() ? "" : " ||" + generated) << "\n"
+                << "  compiler = " << escape_value(quote_argument(action.compiler)) << "\n"
+                << "  flags = $" << flags_var << "\n";
+        }
+
+        // Link or archive edge, relinked when a library it links against changes
+        out << "build " << escape_path(output) << ": "
+            << (action.type == BuildType::STATIC_LIBRARY ? "archive" : "link");
+        for (const std::string& object : objects) {
+            out << " " << escape_path(object);
+        }
+        bool has_libraries = false;
+        for (uint32_t dependency : action.deps) {
+            if (actions[dependency].kind != ActionKind::TARGET) {
+                continue;
+            }
+            out << (has_libraries ? "" : " |");
+            has_libraries = true;
+            for (const std::string& dependency_output : actions[dependency].outputs) {
+                out << " " << escape_path(dependency_output);
+            }
+        }
+        out << "\n";
+        if (action.type != BuildType::STATIC_LIBRARY) {
+            out << "  compiler = " << escape_value(quote_argument(action.compiler)) << "\n"
+                << "  flags = $" << flags_var << "\n"
+                << "  ldflags = " << escape_value(join_arguments(action.link_flags)) << "\n";
+        }
+        out << "\n";
+
+        target_outputs[action.target].push_back(output);
+        defaults.push_back(output);
+    }
+
+    // Target names as aliases, unless a target's output has the same path
+    std::set<std::string> aliases;
+    for (const auto& [target, paths] : target_outputs) {
+        if (outputs.count(target) > 0) {
+            continue;
+        }
+        aliases.insert(target);
+        out << "build " << escape_path(target) << ": phony";
+        for (const std::string& path : paths) {
+            out << " " << escape_path(path);
+        }
+        out << "\n";
+    }
+    out << "\n";
+
+    // Sequences: file operations run in order once every target they build is up to date
+    for (const auto& [name, sequence] : config.sequences) {
+        if (aliases.count(name) > 0 || outputs.count(name) > 0) {
+            std::cerr << "[WARNING] Skipping sequence '" << name << "': the name is already used by a target." << std::endl;
+            continue;
+        }
+
+        std::vector<std::string> inputs;
+        std::string command;
+        for (const Operation& operation : sequence.operations) {
+            if (operation.type == OperationType::BUILD) {
+                auto it = target_outputs.find(operation.target);
+                if (it == target_outputs.end()) {
+                    std::cerr << "[WARNING] Sequence '" << name << "' builds target '" << operation.target
+                              << "', which is not part of the exported plan." << std::endl;
+                    continue;
+                }
+                inputs.insert(inputs.end(), it->second.begin(), it->second.end());
+                continue;
+            }
+            command += (command.empty() ? "" : " && ") + operation_command(operation);
+        }
+
+        out << "build " << escape_path(name) << ": " << (command.empty() ? "phony" : "sequence");
+        if (!inputs.empty()) {
+            out << (command.empty() ? "" : " |");
+            for (const std::string& input : inputs) {
+                out << " " << escape_path(input);
+            }
+        }
+        out << "\n";
+        if (!command.empty()) {
+#ifdef _WIN32
+            command = "cmd /c " + command;
+#endif
+            out << "  cmd = " << escape_value(command) << "\n"
+                << "  name = " << escape_value(name) << "\n";
+        }
+        out << "\n";
+    }
+
+    // Regenerate this file whenever a configuration file changes
+    out << "build " << escape_path(filename) << ": regenerate |";
+    for (const std::string& config_file : config_files) {
+        out << " " << escape_path(config_file);
+    }
+    out << "\n\n";
+
+    out << "default";
+    for (const std::string& path : defaults) {
+        out << " " << escape_path(path);
+    }
+    out << "\n";
+
+    if (!out.good()) {
+        std::cerr << "[ERROR] Failed to write '" << filename << "'." << std::endl;
+        return S_FILE_OPERATION_FAILED;
+    }
+    return S_OK;
+}
+
+std::string NinjaGenerator::escape_path(const std::string& path) {
+    std::string escaped;
+    for (char c : path) {
+        if (c == '$' || c == ' ' || c == ':') {
+            escaped += '$';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string NinjaGenerator::escape_value(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '$') {
+            escaped += '$';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string NinjaGenerator::quote_argument(const std::string& arg) {
+    if (is_plain_argument(arg)) {
+        return arg;
+    }
+#ifdef _WIN32
+    std::string quoted = "\"";
+    for (char c : arg) {
+        if (c == '"') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+#else
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+#endif
+}
+
+std::string NinjaGenerator::join_arguments(const std::vector<std::string>& args) {
+    std::string joined;
+    for (const std::string& arg : args) {
+        if (!joined.empty()) {
+            joined += ' ';
+        }
+        joined += quote_argument(arg);
+    }
+    return joined;
+}
+
+std::string NinjaGenerator::object_path(const BuildAction& action, const std::string& source) {
+    // Objects are kept apart per platform and target; sources outside the project stay inside the object directory
+    std::string target = action.target;
+    std::replace(target.begin(), target.end(), ':', '/');
+
+    std::string relative = source;
+    std::replace(relative.begin(), relative.end(), '\\', '/');
+    std::replace(relative.begin(), relative.end(), ':', '_');
+    size_t pos = 0;
+    while ((pos = relative.find("..", pos)) != std::string::npos) {
+        relative.replace(pos, 2, "__");
+    }
+    relative.erase(0, relative.find_first_not_of('/'));
+
+    return std::string(OBJECT_DIR) + "/" + action.platform.to_string() + "/" + target + "/" + relative + ".o";
+}
+
+std::string NinjaGenerator::operation_command(const Operation& operation) {
+    const std::string& path = operation.target;
+    bool is_directory = std::filesystem::is_directory(path);
+    std::string parent = std::filesystem::path(operation.destination).parent_path().string();
+
+#ifdef _WIN32
+    switch (operation.type) {
+        case OperationType::COPY:
+            if (is_directory) {
+                return "xcopy /E /I /Y /Q " + quote_argument(native_path(path)) + " " +
+                       quote_argument(native_path(operation.destination));
+            }
+            return (parent.empty() ? "" : "(if not exist " + quote_argument(native_path(parent)) + " mkdir " +
+                                              quote_argument(native_path(parent)) + ") && ") +
+                   "copy /Y " + quote_argument(native_path(path)) + " " + quote_argument(native_path(operation.destination));
+        case OperationType::REMOVE:
+            return is_directory ? "(if exist " + quote_argument(native_path(path)) + " rmdir /S /Q " + quote_argument(native_path(path)) + ")"
+                                : "(if exist " + quote_argument(native_path(path)) + " del /Q " + quote_argument(native_path(path)) + ")";
+        case OperationType::MKDIR:
+            return "(if not exist " + quote_argument(native_path(path)) + " mkdir " + quote_argument(native_path(path)) + ")";
+        case OperationType::BUILD:
+            break;
+    }
+#else
+    switch (operation.type) {
+        case OperationType::COPY:
+            if (is_directory) {
+                return "mkdir -p " + quote_argument(operation.destination) + " && cp -R " +
+                       quote_argument(path + "/.") + " " + quote_argument(operation.destination);
+            }
+            return (parent.empty() ? "" : "mkdir -p " + quote_argument(parent) + " && ") +
+                   "cp " + quote_argument(path) + " " + quote_argument(operation.destination);
+        case OperationType::REMOVE:
+            return "rm -rf " + quote_argument(path);
+        case OperationType::MKDIR:
+            return "mkdir -p " + quote_argument(path);
+        case OperationType::BUILD:
+            break;
+    }
+#endif
+    return "";
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef NINJA_GENERATOR_H
+#define NINJA_GENERATOR_H
+
+#include "BuildPlan.h"
+#include "ProjectConfig.h"
+#include "core.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Exports a build plan as a build.ninja file
+ *
+ * Every source file of a planned action gets its own compile edge (with a gcc style
+ * depfile, so ninja tracks header dependencies), followed by a link edge per action
+ * that depends on the outputs of the libraries it links against. Generator rules
+ * become edges of their own, which the compile edges of their targets wait for. Each target name
+ * becomes a phony alias for its outputs and each sequence becomes an edge that runs
+ * its file operations after building the targets it references.
+ */
+class NinjaGenerator {
+public:
+    /**
+     * @brief Writes the ninja file
+     * @param config The project configuration (for sequences)
+     * @param plan The resolved build plan
+     * @param platforms Platforms whose actions are exported
+     * @param config_files Configuration files the plan was created from
+     * @param regenerate_command Command that regenerates the file when a configuration file changes
+     * @param filename Path of the ninja file to write
+     * @return S_OK on success, S_FILE_OPERATION_FAILED if the file cannot be written
+     */
+    static E_RESULT generate(const ProjectConfig& config, const BuildPlan& plan, const std::vector<Platform>& platforms,
+                             const std::vector<std::string>& config_files, const std::string& regenerate_command,
+                             const std::string& filename);
+
+private:
+    /**
+     * @brief Escapes a path for use in a build statement
+     */
+    static std::string escape_path(const std::string& path);
+
+    /**
+     * @brief Escapes a value for use in a variable assignment
+     */
+    static std::string escape_value(const std::string& value);
+
+    /**
+     * @brief Quotes a single argument for the shell ninja runs commands with
+     */
+    static std::string quote_argument(const std::string& arg);
+
+    /**
+     * @brief Quotes and joins arguments into one command line fragment
+     */
+    static std::string join_arguments(const std::vector<std::string>& args);
+
+    /**
+     * @brief Gets the object file of a source file of an action
+     */
+    static std::string object_path(const BuildAction& action, const std::string& source);
+
+    /**
+     * @brief Translates a non-build sequence operation into a shell command
+     */
+    static std::string operation_command(const Operation& operation);
+};
+
+#endif // NINJA_GENERATOR_H
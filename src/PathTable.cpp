@@ -0,0 +1,125 @@
+#include "PathTable.h"
+#include <cstring>
+
+namespace {
+    const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+    const size_t INITIAL_SLOT_COUNT = 1024;
+}
+
+PathTable::PathTable()
+    : block_used_(0), block_capacity_(0), slots_(INITIAL_SLOT_COUNT, INVALID_PATH_ID) {
+}
+
+PathId PathTable::intern(std::string_view path) {
+    uint32_t path_hash = hash(path);
+    size_t mask = slots_.size() - 1;
+
+    for (size_t slot = path_hash & mask; ; slot = (slot + 1) & mask) {
+        PathId id = slots_[slot];
+        if (id == INVALID_PATH_ID) {
+            break;
+        }
+        const Entry& entry = entries_[id];
+        if (entry.hash == path_hash && std::string_view(entry.data, entry.length) == path) {
+            return id;
+        }
+    }
+
+    PathId id = static_cast<PathId>(entries_.size());
+    entries_.push_back({store(path), static_cast<uint32_t>(path.size()), path_hash});
+
+    // Keep the load factor below 1/2
+    if (entries_.size() * 2 > slots_.size()) {
+        grow();
+    } else {
+        for (size_t slot = path_hash & mask; ; slot = (slot + 1) & mask) {
+            if (slots_[slot] == INVALID_PATH_ID) {
+                slots_[slot] = id;
+                break;
+            }
+        }
+    }
+
+    return id;
+}
+
+PathId PathTable::find(std::string_view path) const {
+    uint32_t path_hash = hash(path);
+    size_t mask = slots_.size() - 1;
+
+    for (size_t slot = path_hash & mask; ; slot = (slot + 1) & mask) {
+        PathId id = slots_[slot];
+        if (id == INVALID_PATH_ID) {
+            return INVALID_PATH_ID;
+        }
+        const Entry& entry = entries_[id];
+        if (entry.hash == path_hash && std::string_view(entry.data, entry.length) == path) {
+            return id;
+        }
+    }
+}
+
+std::string_view PathTable::get(PathId id) const {
+    if (id >= entries_.size()) {
+        return std::string_view();
+    }
+    return std::string_view(entries_[id].data, entries_[id].length);
+}
+
+std::string PathTable::str(PathId id) const {
+    return std::string(get(id));
+}
+
+size_t PathTable::size() const {
+    return entries_.size();
+}
+
+PathTable& PathTable::shared() {
+    static PathTable table;
+    return table;
+}
+
+const char* PathTable::store(std::string_view path) {
+    if (path.size() > ARENA_BLOCK_SIZE / 4) {
+        // Unusually long paths get a dedicated block so they don't waste arena space
+        blocks_.insert(blocks_.begin(), std::make_unique<char[]>(path.size()));
+        std::memcpy(blocks_.front().get(), path.data(), path.size());
+        return blocks_.front().get();
+    }
+
+    if (blocks_.empty() || block_used_ + path.size() > block_capacity_) {
+        blocks_.push_back(std::make_unique<char[]>(ARENA_BLOCK_SIZE));
+        block_used_ = 0;
+        block_capacity_ = ARENA_BLOCK_SIZE;
+    }
+
+    char* destination = blocks_.back().get() + block_used_;
+    std::memcpy(destination, path.data(), path.size());
+    block_used_ += path.size();
+    return destination;
+}
+
+void PathTable::grow() {
+    std::vector<PathId> slots(slots_.size() * 2, INVALID_PATH_ID);
+    size_t mask = slots.size() - 1;
+
+    for (PathId id = 0; id < entries_.size(); ++id) {
+        for (size_t slot = entries_[id].hash & mask; ; slot = (slot + 1) & mask) {
+            if (slots[slot] == INVALID_PATH_ID) {
+                slots[slot] = id;
+                break;
+            }
+        }
+    }
+
+    slots_.swap(slots);
+}
+
+uint32_t PathTable::hash(std::string_view path) {
+    uint32_t value = 2166136261u;
+    for (char c : path) {
+        value ^= static_cast<unsigned char>(c);
+        value *= 16777619u;
+    }
+    return value;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef PATH_TABLE_H
+#define PATH_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Compact 32-bit identifier of an interned path
+ */
+typedef uint32_t PathId;
+
+/**
+ * @brief Identifier returned when a path is not in the table
+ */
+const PathId INVALID_PATH_ID = 0xFFFFFFFFu;
+
+/**
+ * @brief Interns path strings so each distinct path is stored exactly once
+ *
+ * Path bytes live in large arena blocks that are never moved, so views returned
+ * by get() stay valid for the lifetime of the table. Lookups go through a flat
+ * open-addressing hash table of ids instead of a node-based map.
+ */
+class PathTable {
+public:
+    PathTable();
+
+    /**
+     * @brief Returns the id of a path, adding it to the table if necessary
+     * @param path Path to intern (used verbatim, callers normalize if needed)
+     * @return Id of the path
+     */
+    PathId intern(std::string_view path);
+
+    /**
+     * @brief Looks up the id of a path without adding it
+     * @param path Path to look up
+     * @return Id of the path, or INVALID_PATH_ID if it was never interned
+     */
+    PathId find(std::string_view path) const;
+
+    /**
+     * @brief Gets the path for an id
+     * @param id Id returned by intern()
+     * @return View of the interned path
+     */
+    std::string_view get(PathId id) const;
+
+    /**
+     * @brief Gets the path for an id as a string
+     * @param id Id returned by intern()
+     * @return Copy of the interned path
+     */
+    std::string str(PathId id) const;
+
+    /**
+     * @brief Gets the number of interned paths (ids are 0 .. size()-1)
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the process-wide table shared by the watcher and dependency graphs
+     */
+    static PathTable& shared();
+
+private:
+    struct Entry {
+        const char* data;
+        uint32_t length;
+        uint32_t hash;
+    };
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_used_;
+    size_t block_capacity_;
+    std::vector<Entry> entries_;
+    std::vector<PathId> slots_;  // Open-addressing hash table, INVALID_PATH_ID marks empty slots
+
+    /**
+     * @brief Copies a path into the arena
+     * @param path Path to store
+     * @return Pointer to the stored bytes
+     */
+    const char* store(std::string_view path);
+
+    /**
+     * @brief Doubles the hash table and reinserts all ids
+     */
+    void grow();
+
+    /**
+     * @brief Hashes a path (FNV-1a)
+     */
+    static uint32_t hash(std::string_view path);
+};
+
+#endif // PATH_TABLE_H
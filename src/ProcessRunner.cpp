@@ -0,0 +1,221 @@
+#include "ProcessRunner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+    // Splits the output of a command into lines; a final line without line end is passed by flush()
+    class LineSplitter {
+    public:
+        explicit LineSplitter(const std::function<void(const std::string&)>& output) : output_(output) {}
+
+        void add(const char* data, size_t size) {
+            buffer_.append(data, size);
+            size_t start = 0;
+            size_t end;
+            while ((end = buffer_.find('\n', start)) != std::string::npos) {
+                size_t length = end > start && buffer_[end - 1] == '\r' ? end - start - 1 : end - start;
+                output_(buffer_.substr(start, length));
+                start = end + 1;
+            }
+            buffer_.erase(0, start);
+        }
+
+        void flush() {
+            if (!buffer_.empty()) {
+                output_(buffer_);
+                buffer_.clear();
+            }
+        }
+
+    private:
+        const std::function<void(const std::string&)>& output_;
+        std::string buffer_;
+    };
+}
+
+int ProcessRunner::run(const std::string& command, bool background,
+                       const std::function<void(const std::string&)>& output) {
+#ifdef _WIN32
+    (void)background;
+    if (is_cancelled()) {
+        return CANCELLED;
+    }
+    int result;
+    if (output) {
+        FILE* pipe = _popen((command + " 2>&1").c_str(), "r");
+        if (pipe == nullptr) {
+            return -1;
+        }
+        LineSplitter lines(output);
+        char buffer[4096];
+        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            lines.add(buffer, std::strlen(buffer));
+        }
+        lines.flush();
+        result = _pclose(pipe);
+    } else {
+        result = std::system(command.c_str());
+    }
+    return is_cancelled() ? CANCELLED : result;
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cancelled_) {
+        return CANCELLED;
+    }
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+
+    // Commands get the default SIGPIPE action even if the caller ignores it
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    short flags = POSIX_SPAWN_SETSIGDEF;
+    if (process_groups_) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup(&attributes, 0);
+    }
+    posix_spawnattr_setflags(&attributes, flags);
+
+    // Captured output is read from a pipe that only the command inherits, as its stdout and stderr
+    int pipe_fds[2] = {-1, -1};
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    if (output) {
+#ifdef __linux__
+        int pipe_result = pipe2(pipe_fds, O_CLOEXEC);
+#else
+        int pipe_result = pipe(pipe_fds);
+        if (pipe_result == 0) {
+            fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+        }
+#endif
+        if (pipe_result != 0) {
+            posix_spawn_file_actions_destroy(&file_actions);
+            posix_spawnattr_destroy(&attributes);
+            return -1;
+        }
+        posix_spawn_file_actions_adddup2(&file_actions, pipe_fds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&file_actions, pipe_fds[1], STDERR_FILENO);
+    }
+
+    // Spawned under the lock, so cancel() either sees the process or prevents it from starting
+    const char* argv[] = {"sh", "-c", command.c_str(), nullptr};
+    pid_t pid;
+    int error;
+    if (background && background_priority_ != nullptr) {
+        // posix_spawn cannot lower priorities, so background jobs lower them between fork and exec,
+        // before the shell or any compiler it starts runs. The child only calls async-signal-safe functions
+        pid = fork();
+        if (pid == 0) {
+            signal(SIGPIPE, SIG_DFL);
+            if (process_groups_) {
+                setpgid(0, 0);
+            }
+            if (output) {
+                dup2(pipe_fds[1], STDOUT_FILENO);
+                dup2(pipe_fds[1], STDERR_FILENO);
+            }
+            background_priority_->apply();
+            execve("/bin/sh", const_cast<char* const*>(argv), environ);
+            _exit(127);
+        }
+        error = pid < 0 ? errno : 0;
+        // Set from both sides, so the group exists before cancel() signals it, as with posix_spawn.
+        // Fails harmlessly once the child has already set it and executed the shell
+        if (pid > 0 && process_groups_) {
+            setpgid(pid, pid);
+        }
+    } else {
+        error = posix_spawn(&pid, "/bin/sh", &file_actions, &attributes, const_cast<char* const*>(argv), environ);
+    }
+    posix_spawn_file_actions_destroy(&file_actions);
+    posix_spawnattr_destroy(&attributes);
+    if (output) {
+        close(pipe_fds[1]);
+    }
+    if (error != 0) {
+        if (output) {
+            close(pipe_fds[0]);
+        }
+        return -1;
+    }
+    running_.insert(pid);
+    lock.unlock();
+
+    // The pipe reaches its end once the command and every process it started have exited
+    if (output) {
+        LineSplitter lines(output);
+        char buffer[4096];
+        ssize_t count;
+        while ((count = read(pipe_fds[0], buffer, sizeof(buffer))) != 0) {
+            if (count > 0) {
+                lines.add(buffer, static_cast<size_t>(count));
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+        lines.flush();
+        close(pipe_fds[0]);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+
+    lock.lock();
+    running_.erase(pid);
+    if (cancelled_) {
+        return CANCELLED;
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+#endif
+}
+
+void ProcessRunner::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+#ifndef _WIN32
+    for (int pid : running_) {
+        // A negative id signals the whole process group
+        kill(process_groups_ ? -pid : pid, SIGTERM);
+    }
+#endif
+}
+
+void ProcessRunner::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = false;
+}
+
+bool ProcessRunner::is_cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+void ProcessRunner::set_process_groups(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    process_groups_ = enabled;
+}
+
+void ProcessRunner::set_background_priority(const JobPriority* priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    background_priority_ = priority;
+}
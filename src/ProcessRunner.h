@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef PROCESS_RUNNER_H
+#define PROCESS_RUNNER_H
+
+#include "JobPriority.h"
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+
+/**
+ * @brief Runs shell commands and allows cancelling the ones still running
+ *
+ * On POSIX systems commands are started with posix_spawn, or with fork and exec when they run
+ * with the background priority, which is applied before exec. With process groups enabled each
+ * command gets a group of its own, so cancel() stops the shell together with the compiler
+ * and linker processes it started. Elsewhere commands run through std::system and
+ * cancel() only prevents further commands from starting.
+ */
+class ProcessRunner {
+public:
+    /**
+     * @brief Exit status reported for commands that were cancelled
+     */
+    static const int CANCELLED = -2;
+
+    ProcessRunner() = default;
+    ProcessRunner(const ProcessRunner&) = delete;
+    ProcessRunner& operator=(const ProcessRunner&) = delete;
+
+    /**
+     * @brief Runs a command through the shell and waits for it
+     * @param command Command line
+     * @param background true to run the command with the background priority
+     * @param output Receives each line the command writes to stdout or stderr; if empty, they go to the terminal
+     * @return Exit code of the command, -1 if it could not be started, or CANCELLED
+     */
+    int run(const std::string& command, bool background = false,
+            const std::function<void(const std::string&)>& output = nullptr);
+
+    /**
+     * @brief Stops all running commands (SIGTERM to their process groups) and refuses new ones until reset()
+     */
+    void cancel();
+
+    /**
+     * @brief Allows commands to run again after cancel()
+     */
+    void reset();
+
+    /**
+     * @brief Checks if cancel() was called since the last reset()
+     */
+    bool is_cancelled() const;
+
+    /**
+     * @brief Starts each command in a process group of its own
+     *
+     * Commands in their own group do not receive the terminal's Ctrl+C, so this is only
+     * enabled by callers that cancel running commands themselves.
+     * @param enabled true to use process groups
+     */
+    void set_process_groups(bool enabled);
+
+    /**
+     * @brief Sets the priority of commands run in the background
+     * @param priority Priority to apply (must outlive its use), nullptr to run them normally
+     */
+    void set_background_priority(const JobPriority* priority);
+
+private:
+    mutable std::mutex mutex_;
+    std::set<int> running_;     // Process ids (and group ids) of running commands
+    bool cancelled_ = false;
+    bool process_groups_ = false;
+    const JobPriority* background_priority_ = nullptr;
+};
+
+#endif // PROCESS_RUNNER_H
@@ -1,7 +1,9 @@
 #include "ProjectConfig.h"
+#include "FileSystemUtils.h"
 
 bool BuildTarget::is_valid() const {
-    return !output_name.empty() && !sources.empty();
+    // Until the patterns are expanded, a target is assumed to have sources if it declares any
+    return !output_name.empty() && (sources_resolved ? !sources.empty() : !source_patterns.empty());
 }
 
 std::string BuildTarget::get_output_extension(const Platform& platform) const {
@@ -94,7 +96,7 @@ bool ProjectConfig::is_valid() const {
     }
     
     // Legacy check
-    return !compiler.empty() && !output_name.empty() && !sources.empty();
+    return !compiler.empty() && !output_name.empty() && !source_patterns.empty();
 }
 
 std::vector<std::string> ProjectConfig::get_validation_errors() const {
@@ -120,11 +122,12 @@ std::vector<std::string> ProjectConfig::get_validation_errors() const {
             
             for (const auto& [name, target] : targets) {
                 if (!target.is_valid()) {
-                    if (target.output_name.empty() && target.sources.empty()) {
+                    bool has_sources = target.sources_resolved ? !target.sources.empty() : !target.source_patterns.empty();
+                    if (target.output_name.empty() && !has_sources) {
                         errors.push_back("    * Target '" + name + "': missing both 'output_name' and 'sources'");
                     } else if (target.output_name.empty()) {
                         errors.push_back("    * Target '" + name + "': missing 'output_name'");
-                    } else if (target.sources.empty()) {
+                    } else if (!has_sources) {
                         errors.push_back("    * Target '" + name + "': missing 'sources' (e.g., " + name + ".sources: src/**.[c,cpp])");
                     }
                 }
@@ -138,7 +141,7 @@ std::vector<std::string> ProjectConfig::get_validation_errors() const {
         if (output_name.empty()) {
             errors.push_back("  - Missing 'output_name' field (e.g., output_name: myapp)");
         }
-        if (sources.empty()) {
+        if (source_patterns.empty()) {
             errors.push_back("  - Missing 'sources' field (e.g., sources: src/**.[c,cpp])");
         }
     }
@@ -152,7 +155,7 @@ void ProjectConfig::apply_defaults() {
     }
     
     // If we have legacy configuration, convert it
-    if (!output_name.empty() && !sources.empty() && targets.empty()) {
+    if (!output_name.empty() && !source_patterns.empty() && targets.empty()) {
         convert_legacy_to_targets();
     }
     
@@ -171,9 +174,116 @@ void ProjectConfig::convert_legacy_to_targets() {
     default_target.output_name = output_name;
     default_target.cxx_flags = cxx_flags;
     default_target.sources = sources;
+    default_target.source_patterns = source_patterns;
     default_target.include_dirs = include_dirs;
     default_target.library_dirs = library_dirs;
     default_target.libraries = libraries;
     
     targets["default"] = default_target;
-}
\ No newline at end of file
+}
+
+std::vector<std::string> ProjectConfig::get_include_dirs(const BuildTarget& target, const Platform* platform) const {
+    // Same order as the -I arguments of the build plan
+    std::vector<std::string> dirs = global_include_dirs;
+    if (platform != nullptr) {
+        auto global_platform = global_platform_configs.find(*platform);
+        if (global_platform != global_platform_configs.end()) {
+            dirs.insert(dirs.end(), global_platform->second.include_dirs.begin(), global_platform->second.include_dirs.end());
+        }
+    }
+    dirs.insert(dirs.end(), target.include_dirs.begin(), target.include_dirs.end());
+    if (platform != nullptr) {
+        for (const auto& [plat, plat_config] : target.platform_configs) {
+            if (plat.matches(*platform)) {
+                dirs.insert(dirs.end(), plat_config.include_dirs.begin(), plat_config.include_dirs.end());
+                break;
+            }
+        }
+    }
+    return dirs;
+}
+
+std::vector<std::string> ProjectConfig::get_target_dependencies(const BuildTarget& target) const {
+    std::vector<std::string> libs = target.libraries;
+    for (const auto& [platform, plat_config] : target.platform_configs) {
+        libs.insert(libs.end(), plat_config.libraries.begin(), plat_config.libraries.end());
+    }
+
+    std::vector<std::string> dependencies;
+    for (const auto& [name, other] : targets) {
+        if (name == target.name) {
+            continue;
+        }
+        for (const std::string& lib : libs) {
+            if (lib == name || lib == other.output_name) {
+                dependencies.push_back(name);
+                break;
+            }
+        }
+    }
+
+    return dependencies;
+}
+
+std::vector<std::string> ProjectConfig::get_target_rules(const BuildTarget& target) const {
+    std::vector<std::string> patterns = target.source_patterns;
+    for (const auto& [platform, plat_config] : target.platform_configs) {
+        patterns.insert(patterns.end(), plat_config.source_patterns.begin(), plat_config.source_patterns.end());
+    }
+
+    std::vector<std::string> used;
+    for (const auto& [name, rule] : rules) {
+        bool covered = false;
+        for (const std::string& output : rule.outputs) {
+            for (const std::string& pattern : patterns) {
+                covered = covered || FileSystemUtils::pattern_covers(pattern, output);
+            }
+        }
+        if (covered) {
+            used.push_back(name);
+        }
+    }
+
+    return used;
+}
+
+std::vector<std::string> ProjectConfig::get_rule_dependencies(const GeneratorRule& rule) const {
+    std::vector<std::string> dependencies;
+    for (const auto& [name, other] : rules) {
+        if (name == rule.name) {
+            continue;
+        }
+        bool covered = false;
+        for (const std::string& output : other.outputs) {
+            for (const std::string& pattern : rule.input_patterns) {
+                covered = covered || FileSystemUtils::pattern_covers(pattern, output, false);
+            }
+        }
+        if (covered) {
+            dependencies.push_back(name);
+        }
+    }
+
+    return dependencies;
+}
+
+void ProjectConfig::clear_resolved_sources() {
+    auto clear = [](auto& list) {
+        list.sources.clear();
+        list.sources_resolved = false;
+    };
+
+    for (auto& [name, target] : targets) {
+        clear(target);
+        for (auto& [platform, plat_config] : target.platform_configs) {
+            clear(plat_config);
+        }
+    }
+    for (auto& [platform, plat_config] : global_platform_configs) {
+        clear(plat_config);
+    }
+    for (auto& [name, rule] : rules) {
+        rule.inputs.clear();
+        rule.inputs_resolved = false;
+    }
+}
@@ -49,9 +49,12 @@ struct BuildTarget {
     std::string output_name;
     std::vector<std::string> cxx_flags;
     std::vector<std::string> sources;
+    std::vector<std::string> source_patterns;  // Raw patterns as written in .bodge
     std::vector<std::string> include_dirs;
     std::vector<std::string> library_dirs;
     std::vector<std::string> libraries;
+    bool sources_resolved = false;  // Set once source_patterns have been expanded into sources
+    std::string base_dir;           // Root of the sub-project the target comes from (empty for the main project)
     
     // Platform-specific configurations
     std::map<Platform, PlatformConfig> platform_configs;
@@ -86,6 +89,22 @@ struct Sequence {
     std::vector<Operation> operations;
 };
 
+/**
+ * @brief Represents a generator rule that produces files (e.g. sources from .proto files)
+ *
+ * Rules run before the targets that list one of their outputs in their sources, and
+ * only when their inputs or command have changed since the last run.
+ */
+struct GeneratorRule {
+    std::string name;
+    std::string command;                       // Shell command; $in and $out expand to the inputs and outputs
+    std::vector<std::string> input_patterns;   // Raw patterns as written in .bodge
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::string depfile;                       // Optional Makefile-style file listing additional inputs
+    bool inputs_resolved = false;              // Set once input_patterns have been expanded into inputs
+};
+
 /**
  * @brief Enhanced configuration structure that supports multiple targets and sequences
  */
@@ -109,6 +128,12 @@ struct ProjectConfig {
     
     // Build sequences
     std::map<std::string, Sequence> sequences;
+
+    // Generator rules
+    std::map<std::string, GeneratorRule> rules;
+
+    // Tests run by the daemon after it rebuilt a target: command by target name, empty to run the target's executable
+    std::map<std::string, std::string> daemon_tests;
     
     // Global platform-specific configurations
     std::map<Platform, PlatformConfig> global_platform_configs;
@@ -118,6 +143,7 @@ struct ProjectConfig {
     std::string output_name;
     std::vector<std::string> cxx_flags;
     std::vector<std::string> sources;
+    std::vector<std::string> source_patterns;
     std::vector<std::string> include_dirs;
     std::vector<std::string> library_dirs;
     std::vector<std::string> libraries;
@@ -143,6 +169,40 @@ struct ProjectConfig {
      * @brief Converts legacy configuration to modern target-based format
      */
     void convert_legacy_to_targets();
+
+    /**
+     * @brief Gets the include directories a target is compiled with for a platform
+     * @param target The target to collect include directories for
+     * @param platform Platform to add the platform-specific directories of, nullptr for none
+     * @return Global and target include directories in search order, as passed to the compiler
+     */
+    std::vector<std::string> get_include_dirs(const BuildTarget& target, const Platform* platform = nullptr) const;
+
+    /**
+     * @brief Gets the targets a target links against
+     * @param target The target to inspect
+     * @return Names of targets referenced by the target's libraries (by name or output name)
+     */
+    std::vector<std::string> get_target_dependencies(const BuildTarget& target) const;
+
+    /**
+     * @brief Gets the generator rules whose outputs a target uses
+     * @param target The target to inspect
+     * @return Names of rules with an output covered by one of the target's source patterns
+     */
+    std::vector<std::string> get_target_rules(const BuildTarget& target) const;
+
+    /**
+     * @brief Gets the generator rules whose outputs another rule uses as inputs
+     * @param rule The rule to inspect
+     * @return Names of rules with an output covered by one of the rule's input patterns
+     */
+    std::vector<std::string> get_rule_dependencies(const GeneratorRule& rule) const;
+
+    /**
+     * @brief Discards all expanded sources so that they are expanded again on demand
+     */
+    void clear_resolved_sources();
 };
 
 #endif // PROJECT_CONFIG_H
\ No newline at end of file
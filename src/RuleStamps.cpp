@@ -0,0 +1,144 @@
+#include "RuleStamps.h"
+#include "ConfigSnapshot.h"
+#include "FileSystemUtils.h"
+#include "core.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    const char* RULE_STAMP_DIR = BODGE_CACHE_DIR "/rules";
+}
+
+bool RuleStamps::is_up_to_date(const BuildAction& action) {
+    for (const std::string& output : action.outputs) {
+        if (!FileSystemUtils::file_exists(output)) {
+            return false;
+        }
+    }
+
+    std::ifstream in(stamp_path(action.target));
+    std::string line;
+    if (!in.is_open() || !std::getline(in, line)) {
+        return false;
+    }
+
+    std::vector<std::string> depfile_inputs;
+    std::string input;
+    while (std::getline(in, input)) {
+        depfile_inputs.push_back(input);
+    }
+
+    return line == std::to_string(signature(action, depfile_inputs));
+}
+
+bool RuleStamps::record(const BuildAction& action) {
+    std::vector<std::string> depfile_inputs;
+    if (!action.depfile.empty()) {
+        depfile_inputs = read_depfile(action.depfile);
+    }
+
+    try {
+        std::filesystem::create_directories(RULE_STAMP_DIR);
+    } catch (const std::filesystem::filesystem_error&) {
+        return false;
+    }
+
+    std::ofstream out(stamp_path(action.target), std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << signature(action, depfile_inputs) << "\n";
+    for (const std::string& input : depfile_inputs) {
+        out << input << "\n";
+    }
+    return out.good();
+}
+
+std::string RuleStamps::stamp_path(const std::string& rule_name) {
+    // "_" starts an escape, so distinct names like "lib/proto:gen" and "lib_proto_gen" keep distinct files
+    std::string file;
+    for (char c : rule_name) {
+        if (c == '_') {
+            file += "__";
+        } else if (c == '/') {
+            file += "_s";
+        } else if (c == '\\') {
+            file += "_b";
+        } else if (c == ':') {
+            file += "_c";
+        } else {
+            file += c;
+        }
+    }
+    return std::string(RULE_STAMP_DIR) + "/" + file + ".stamp";
+}
+
+uint64_t RuleStamps::signature(const BuildAction& action, const std::vector<std::string>& depfile_inputs) {
+    std::string state = action.command;
+    auto add_input = [&](const std::string& path) {
+        FileStamp stamp;
+        if (!FileSystemUtils::get_file_stamp(path, stamp)) {
+            stamp.mtime = -1;
+        }
+        state += '\0' + path + '\0' + std::to_string(stamp.mtime) + '\0' + std::to_string(stamp.size);
+    };
+
+    for (const std::string& input : action.inputs) {
+        add_input(input);
+    }
+    for (const std::string& input : depfile_inputs) {
+        add_input(input);
+    }
+
+    return ConfigSnapshot::hash_content(state);
+}
+
+std::vector<std::string> RuleStamps::read_depfile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return {};
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string content = buffer.str();
+
+    // "out1 out2: in1 in2 \<newline> in3", where "\ " is an escaped space
+    std::vector<std::string> inputs;
+    std::string current;
+    bool after_colon = false;
+    for (size_t i = 0; i < content.size(); ++i) {
+        char c = content[i];
+        if (c == '\\' && i + 1 < content.size() && (content[i + 1] == ' ' || content[i + 1] == '\n' || content[i + 1] == '\r')) {
+            if (content[i + 1] == ' ') {
+                current += ' ';
+            }
+            ++i;
+            continue;
+        }
+        if (!after_colon) {
+            // The target list ends at a colon followed by whitespace (not a drive letter)
+            if (c == ':' && (i + 1 == content.size() || content[i + 1] == ' ' || content[i + 1] == '\n' ||
+                             content[i + 1] == '\r' || content[i + 1] == '\t')) {
+                after_colon = true;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (!current.empty()) {
+                inputs.push_back(current);
+                current.clear();
+            }
+            if (c == '\n') {
+                after_colon = false;
+            }
+            continue;
+        }
+        current += c;
+    }
+    if (!current.empty()) {
+        inputs.push_back(current);
+    }
+
+    return inputs;
+}
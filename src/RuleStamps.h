@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef RULE_STAMPS_H
+#define RULE_STAMPS_H
+
+#include "BuildPlan.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Remembers the state generator rules last ran successfully in
+ *
+ * Each rule has a stamp file in the bodge cache directory holding a signature of its
+ * command and the modification times and sizes of its inputs, including the inputs
+ * listed in its depfile. A rule is up to date while the signature matches and all of
+ * its outputs exist. Stamps are per rule, so rules running in parallel never share a file.
+ */
+class RuleStamps {
+public:
+    /**
+     * @brief Checks if a rule can be skipped
+     * @param action The rule action
+     * @return true if the command and inputs are unchanged and every output exists
+     */
+    static bool is_up_to_date(const BuildAction& action);
+
+    /**
+     * @brief Records a successful run of a rule
+     * @param action The rule action that just ran
+     * @return true if the stamp was written
+     */
+    static bool record(const BuildAction& action);
+
+private:
+    /**
+     * @brief Gets the stamp file of a rule
+     * @param rule_name Name of the rule, "<project>:<rule>" for rules of sub-projects
+     * @return Path in the stamp directory; every rule name maps to a file of its own
+     */
+    static std::string stamp_path(const std::string& rule_name);
+
+    /**
+     * @brief Computes the signature of a rule's command and inputs
+     * @param action The rule action
+     * @param depfile_inputs Additional inputs read from the depfile
+     */
+    static uint64_t signature(const BuildAction& action, const std::vector<std::string>& depfile_inputs);
+
+    /**
+     * @brief Reads the prerequisites from a Makefile-style depfile
+     * @param path Path of the depfile
+     * @return Listed prerequisites; empty if the file cannot be read
+     */
+    static std::vector<std::string> read_depfile(const std::string& path);
+};
+
+#endif // RULE_STAMPS_H
@@ -132,6 +132,12 @@ void Strings::load_translations() {
     en[StringID::CMD_LIST] = "  list               - List available targets and sequences";
     zh[StringID::CMD_LIST] = "  list               - 列出可用的目标和序列";
     
+    en[StringID::CMD_WORKSPACE] = "  workspace [target] - Build all .bodge projects below the current directory";
+    zh[StringID::CMD_WORKSPACE] = "  workspace [目标]   - 构建当前目录下的所有.bodge项目";
+    
+    en[StringID::CMD_GENERATE] = "  generate ninja     - Write a build.ninja file for the project";
+    zh[StringID::CMD_GENERATE] = "  generate ninja     - 为项目生成build.ninja文件";
+    
     en[StringID::CMD_PLATFORM] = "  platform           - Show current platform information";
     zh[StringID::CMD_PLATFORM] = "  platform           - 显示当前平台信息";
     
@@ -157,6 +163,36 @@ void Strings::load_translations() {
     en[StringID::OPT_LOG] = "  --log=<file>           - Log file for watch mode (default: bodge_daemon.log)";
     zh[StringID::OPT_LOG] = "  --log=<文件>           - 监视模式的日志文件（默认：bodge_daemon.log）";
     
+    en[StringID::OPT_JOBS] = "  --jobs=<n>             - Number of targets built in parallel (default: CPU cores)";
+    zh[StringID::OPT_JOBS] = "  --jobs=<数量>          - 并行构建的目标数量（默认：CPU核心数）";
+
+    en[StringID::OPT_WATCHER] = "  --watcher=<auto|poll>  - Change detection for watch mode (default: auto)";
+    zh[StringID::OPT_WATCHER] = "  --watcher=<auto|poll>  - 监视模式的变更检测方式（默认：auto）";
+
+    en[StringID::OPT_DEBOUNCE] = "  --debounce=<ms>        - Quiet period before a batch of changes is rebuilt (default: 100ms)";
+    zh[StringID::OPT_DEBOUNCE] = "  --debounce=<毫秒>      - 一批更改在重新构建前的静默时间（默认：100毫秒）";
+
+    en[StringID::OPT_MAX_WAIT] = "  --max-wait=<ms>        - Longest a batch of changes is delayed (default: 2000ms)";
+    zh[StringID::OPT_MAX_WAIT] = "  --max-wait=<毫秒>      - 一批更改最长延迟时间（默认：2000毫秒）";
+
+    en[StringID::OPT_METRICS] = "  --metrics=[host:]port  - Serve Prometheus metrics over HTTP (default host: 127.0.0.1)";
+    zh[StringID::OPT_METRICS] = "  --metrics=[主机:]端口  - 通过HTTP提供Prometheus指标（默认主机：127.0.0.1）";
+
+    en[StringID::OPT_NICE] = "  --nice=<1-19>          - Lower the CPU priority of background rebuild jobs";
+    zh[StringID::OPT_NICE] = "  --nice=<1-19>          - 降低后台重新构建任务的CPU优先级";
+
+    en[StringID::OPT_IONICE] = "  --ionice=<idle|0-7>    - I/O class or best-effort level of background rebuild jobs (Linux)";
+    zh[StringID::OPT_IONICE] = "  --ionice=<idle|0-7>    - 后台重新构建任务的I/O类别或尽力而为级别（Linux）";
+
+    en[StringID::OPT_CPU_WEIGHT] = "  --cpu-weight=<1-10000> - Run background rebuild jobs in a cgroup with this cpu.weight (Linux)";
+    zh[StringID::OPT_CPU_WEIGHT] = "  --cpu-weight=<1-10000> - 在具有此cpu.weight的cgroup中运行后台重新构建任务（Linux）";
+
+    en[StringID::OPT_MEMORY_HIGH] = "  --memory-high=<size>   - memory.high of the background cgroup, e.g. 4G (Linux)";
+    zh[StringID::OPT_MEMORY_HIGH] = "  --memory-high=<大小>   - 后台cgroup的memory.high，例如 4G（Linux）";
+
+    en[StringID::OPT_LINE_SENSITIVE] = "  --line-sensitive       - Rebuild for header edits that only move code to other lines (__LINE__)";
+    zh[StringID::OPT_LINE_SENSITIVE] = "  --line-sensitive       - 仅将代码移到其他行的头文件编辑也触发重新构建（__LINE__）";
+    
     // Examples header
     en[StringID::EXAMPLES_HEADER] = "Examples:";
     zh[StringID::EXAMPLES_HEADER] = "示例：";
@@ -180,6 +216,12 @@ void Strings::load_translations() {
     en[StringID::MSG_SUPPORTED_PLATFORMS] = "Supported platforms:";
     zh[StringID::MSG_SUPPORTED_PLATFORMS] = "支持的平台：";
     
+    en[StringID::MSG_DAEMON_BUILD] = "[INFO] A daemon is running for this project, it performs the build.";
+    zh[StringID::MSG_DAEMON_BUILD] = "[信息] 此项目的守护进程正在运行，由其执行构建。";
+    
+    en[StringID::MSG_WAITING_FOR_LOCK] = "[INFO] Another bodge process is building this project, waiting for it to finish...";
+    zh[StringID::MSG_WAITING_FOR_LOCK] = "[信息] 另一个bodge进程正在构建此项目，等待其完成...";
+    
     // Available items
     en[StringID::AVAILABLE_TARGETS] = "Available Targets";
     zh[StringID::AVAILABLE_TARGETS] = "可用目标";
@@ -349,6 +391,9 @@ void Strings::load_translations() {
     en[StringID::ERR_SPECIFY_SEQUENCE] = "[ERROR] Please specify a sequence name.";
     zh[StringID::ERR_SPECIFY_SEQUENCE] = "[错误] 请指定序列名称。";
     
+    en[StringID::ERR_UNKNOWN_GENERATOR] = "[ERROR] Unknown generator (supported: ninja): ";
+    zh[StringID::ERR_UNKNOWN_GENERATOR] = "[错误] 未知生成器（支持：ninja）：";
+    
     en[StringID::ERR_UNKNOWN_COMMAND] = "[ERROR] Unknown command: ";
     zh[StringID::ERR_UNKNOWN_COMMAND] = "[错误] 未知命令：";
     
@@ -403,6 +448,9 @@ void Strings::load_translations() {
     en[StringID::ERR_GET_CURRENT_DIR] = "[ERROR] Failed to get current directory: ";
     zh[StringID::ERR_GET_CURRENT_DIR] = "[错误] 获取当前目录失败：";
     
+    en[StringID::ERR_BUILD_LOCK] = "[ERROR] Failed to lock the project for building: ";
+    zh[StringID::ERR_BUILD_LOCK] = "[错误] 无法锁定项目以进行构建：";
+    
     // Warnings
     en[StringID::WARN_EMPTY_PLATFORM] = "[WARNING] Empty platform value, using current platform";
     zh[StringID::WARN_EMPTY_PLATFORM] = "[警告] 平台值为空，使用当前平台";
@@ -422,6 +470,33 @@ void Strings::load_translations() {
     en[StringID::WARN_INTERVAL_OUT_OF_RANGE] = "[WARNING] Interval out of range (100-3600000ms), using default (1000ms)";
     zh[StringID::WARN_INTERVAL_OUT_OF_RANGE] = "[警告] 间隔超出范围（100-3600000毫秒），使用默认值（1000毫秒）";
     
+    en[StringID::WARN_INVALID_JOBS] = "[WARNING] Invalid jobs value (1-1024)";
+    zh[StringID::WARN_INVALID_JOBS] = "[警告] 并行任务数无效（1-1024）";
+
+    en[StringID::WARN_INVALID_WATCHER] = "[WARNING] Invalid watcher (auto or poll)";
+    zh[StringID::WARN_INVALID_WATCHER] = "[警告] 无效的监视方式（auto 或 poll）";
+
+    en[StringID::WARN_INVALID_DEBOUNCE] = "[WARNING] Invalid debounce value (0-60000ms)";
+    zh[StringID::WARN_INVALID_DEBOUNCE] = "[警告] 无效的防抖时间（0-60000毫秒）";
+
+    en[StringID::WARN_INVALID_MAX_WAIT] = "[WARNING] Invalid max-wait value (0-600000ms)";
+    zh[StringID::WARN_INVALID_MAX_WAIT] = "[警告] 无效的最长等待时间（0-600000毫秒）";
+
+    en[StringID::WARN_INVALID_METRICS] = "[WARNING] Invalid metrics endpoint, expected [host:]port (port 1-65535)";
+    zh[StringID::WARN_INVALID_METRICS] = "[警告] 无效的指标端点，应为 [主机:]端口（端口1-65535）";
+
+    en[StringID::WARN_INVALID_NICE] = "[WARNING] Invalid nice value (1-19)";
+    zh[StringID::WARN_INVALID_NICE] = "[警告] 无效的nice值（1-19）";
+
+    en[StringID::WARN_INVALID_IONICE] = "[WARNING] Invalid ionice value, expected idle or a level 0-7";
+    zh[StringID::WARN_INVALID_IONICE] = "[警告] 无效的ionice值，应为 idle 或级别0-7";
+
+    en[StringID::WARN_INVALID_CPU_WEIGHT] = "[WARNING] Invalid cpu-weight value (1-10000)";
+    zh[StringID::WARN_INVALID_CPU_WEIGHT] = "[警告] 无效的cpu-weight值（1-10000）";
+
+    en[StringID::WARN_INVALID_MEMORY_HIGH] = "[WARNING] Invalid memory-high value, expected a size in bytes with an optional K, M, G or T suffix";
+    zh[StringID::WARN_INVALID_MEMORY_HIGH] = "[警告] 无效的memory-high值，应为字节数，可带 K、M、G 或 T 后缀";
+    
     en[StringID::WARN_EMPTY_LOG_FILE] = "[WARNING] Empty log file path, using default (bodge_daemon.log)";
     zh[StringID::WARN_EMPTY_LOG_FILE] = "[警告] 日志文件路径为空，使用默认值（bodge_daemon.log）";
     
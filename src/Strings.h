@@ -33,6 +33,8 @@ enum class StringID {
     CMD_WATCH,
     CMD_DAEMON,
     CMD_LIST,
+    CMD_WORKSPACE,
+    CMD_GENERATE,
     CMD_PLATFORM,
     CMD_HELP,
     CMD_VERSION,
@@ -43,6 +45,16 @@ enum class StringID {
     OPT_ARCH,
     OPT_INTERVAL,
     OPT_LOG,
+    OPT_JOBS,
+    OPT_WATCHER,
+    OPT_DEBOUNCE,
+    OPT_MAX_WAIT,
+    OPT_METRICS,
+    OPT_NICE,
+    OPT_IONICE,
+    OPT_CPU_WEIGHT,
+    OPT_MEMORY_HIGH,
+    OPT_LINE_SENSITIVE,
     
     // Examples
     EXAMPLES_HEADER,
@@ -54,6 +66,8 @@ enum class StringID {
     MSG_ARCHITECTURE,
     MSG_PLATFORM_STRING,
     MSG_SUPPORTED_PLATFORMS,
+    MSG_DAEMON_BUILD,
+    MSG_WAITING_FOR_LOCK,
     
     // Available items
     AVAILABLE_TARGETS,
@@ -122,6 +136,7 @@ enum class StringID {
     ERR_TARGET_NOT_FOUND,
     ERR_SEQUENCE_NOT_FOUND,
     ERR_SPECIFY_SEQUENCE,
+    ERR_UNKNOWN_GENERATOR,
     ERR_UNKNOWN_COMMAND,
     ERR_USE_HELP,
     ERR_GIT_NOT_AVAILABLE,
@@ -140,6 +155,7 @@ enum class StringID {
     ERR_FILE_WATCHER_INIT,
     ERR_LOG_FILE_OPEN,
     ERR_GET_CURRENT_DIR,
+    ERR_BUILD_LOCK,
     
     // Warnings
     WARN_EMPTY_PLATFORM,
@@ -148,6 +164,15 @@ enum class StringID {
     WARN_EMPTY_INTERVAL,
     WARN_INVALID_INTERVAL,
     WARN_INTERVAL_OUT_OF_RANGE,
+    WARN_INVALID_JOBS,
+    WARN_INVALID_WATCHER,
+    WARN_INVALID_DEBOUNCE,
+    WARN_INVALID_MAX_WAIT,
+    WARN_INVALID_METRICS,
+    WARN_INVALID_NICE,
+    WARN_INVALID_IONICE,
+    WARN_INVALID_CPU_WEIGHT,
+    WARN_INVALID_MEMORY_HIGH,
     WARN_EMPTY_LOG_FILE,
     WARN_INVALID_LOG_FILE,
     WARN_UNKNOWN_OPTION,
@@ -0,0 +1,129 @@
+#include "TestRunner.h"
+#include "Architecture.h"
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    const size_t FAILURE_LINES = 20;    // Last lines of a failed test's output shown on the console
+}
+
+TestRunner::TestRunner(BuildLogger& logger, std::mutex& output_mutex)
+    : logger_(logger), output_mutex_(output_mutex) {
+}
+
+TestRunner::~TestRunner() {
+    for (auto& run : runs_) {
+        run->runner.cancel();
+    }
+    for (auto& run : runs_) {
+        run->thread.join();
+    }
+}
+
+std::string TestRunner::get_test_command(const BuildAction& action, const std::string& test) {
+    if (action.kind != ActionKind::TARGET || action.outputs.empty()) {
+        return "";
+    }
+
+    // The shell only looks up commands without a directory in PATH
+    std::filesystem::path output(action.outputs.front());
+    if (output.is_relative()) {
+        output = std::filesystem::path(".") / output;
+    }
+    std::string out = output.make_preferred().string();
+
+    if (test.empty()) {
+        bool runnable = action.type == BuildType::EXECUTABLE &&
+                        action.platform == ArchitectureDetector::detect_current_platform();
+        return runnable ? out : "";
+    }
+
+    std::string command;
+    for (size_t i = 0; i < test.size(); ++i) {
+        if (test.compare(i, 4, "$out") == 0) {
+            command += out;
+            i += 3;
+        } else {
+            command += test[i];
+        }
+    }
+    return command;
+}
+
+std::string TestRunner::get_test_name(const BuildAction& action) {
+    return action.target + " (" + action.platform.to_string() + ")";
+}
+
+void TestRunner::start(const std::string& name, const std::string& command) {
+    cancel(name);
+    reap();
+
+    runs_.push_back(std::make_unique<Run>());
+    Run& run = *runs_.back();
+    run.name = name;
+    // The test and the processes it starts are stopped together when it is cancelled
+    run.runner.set_process_groups(true);
+    run.thread = std::thread([this, &run, command]() { execute(run, command); });
+}
+
+void TestRunner::cancel(const std::string& name) {
+    for (auto& run : runs_) {
+        if (run->name == name && !run->finished) {
+            run->runner.cancel();
+        }
+    }
+}
+
+void TestRunner::execute(Run& run, const std::string& command) {
+    logger_.log_test(run.name, "Started: " + command);
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::deque<std::string> last_lines;
+    int result = run.runner.run(command, false, [&](const std::string& line) {
+        logger_.log_test(run.name, line);
+        last_lines.push_back(line);
+        if (last_lines.size() > FAILURE_LINES) {
+            last_lines.pop_front();
+        }
+    });
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    std::string status;
+    if (result == 0) {
+        status = "passed";
+    } else if (result == ProcessRunner::CANCELLED) {
+        status = "cancelled, its target changed";
+    } else if (result < 0) {
+        status = "could not be started";
+    } else {
+        status = "failed with exit code " + std::to_string(result);
+    }
+    logger_.log_test(run.name, "Test " + status + " (" + std::to_string(duration) + " ms)");
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        if (result == 0 || result == ProcessRunner::CANCELLED) {
+            std::cout << "[TEST] " << run.name << " " << status << " (" << duration << " ms)" << std::endl;
+        } else {
+            std::cerr << "[TEST] " << run.name << " " << status << " (" << duration << " ms)" << std::endl;
+            for (const std::string& line : last_lines) {
+                std::cerr << "  " << line << std::endl;
+            }
+        }
+    }
+    run.finished = true;
+}
+
+void TestRunner::reap() {
+    for (auto it = runs_.begin(); it != runs_.end();) {
+        if ((*it)->finished) {
+            (*it)->thread.join();
+            it = runs_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef TEST_RUNNER_H
+#define TEST_RUNNER_H
+
+#include "BuildLogger.h"
+#include "BuildPlan.h"
+#include "ProcessRunner.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Runs the tests of targets the daemon rebuilt (see daemon.test in the .bodge file)
+ *
+ * Every test runs on a thread of its own as soon as its target is built, so it runs while
+ * the rest of the rebuild continues. The output of a test is written to the daemon log line
+ * by line and its result is printed to the console. A test is cancelled when its target
+ * changes again, because its result would be stale.
+ */
+class TestRunner {
+public:
+    /**
+     * @brief Constructor
+     * @param logger Daemon log the output of the tests is written to
+     * @param output_mutex Mutex serializing console output
+     */
+    TestRunner(BuildLogger& logger, std::mutex& output_mutex);
+
+    /**
+     * @brief Cancels the running tests and waits for them
+     */
+    ~TestRunner();
+    TestRunner(const TestRunner&) = delete;
+    TestRunner& operator=(const TestRunner&) = delete;
+
+    /**
+     * @brief Gets the command that tests a built action
+     * @param action Action that was built
+     * @param test Command configured for the action's target, empty to run the target's executable
+     * @return Command with $out expanded to the action's output, empty if the action cannot be tested
+     *         (executables built for another platform, or targets that are no executables)
+     */
+    static std::string get_test_command(const BuildAction& action, const std::string& test);
+
+    /**
+     * @brief Gets the name a test of an action is logged and cancelled by
+     * @param action Action that was built
+     * @return Target name and platform, e.g. "tests (linux_x64)"
+     */
+    static std::string get_test_name(const BuildAction& action);
+
+    /**
+     * @brief Starts a test, cancelling a run of it that is still going on
+     * @param name Name of the test
+     * @param command Shell command of the test
+     */
+    void start(const std::string& name, const std::string& command);
+
+    /**
+     * @brief Cancels a running test
+     * @param name Name of the test
+     */
+    void cancel(const std::string& name);
+
+private:
+    /**
+     * @brief Test started by the daemon
+     */
+    struct Run {
+        std::string name;
+        ProcessRunner runner;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    BuildLogger& logger_;
+    std::mutex& output_mutex_;
+    std::list<std::unique_ptr<Run>> runs_;
+
+    /**
+     * @brief Runs a test and reports its result (called on the test's thread)
+     * @param run Test to run
+     * @param command Shell command of the test
+     */
+    void execute(Run& run, const std::string& command);
+
+    /**
+     * @brief Waits for the threads of finished tests
+     */
+    void reap();
+};
+
+#endif // TEST_RUNNER_H
@@ -6,6 +6,9 @@
 // Version of the build system
 #define VERSION "1.0.3.4"
 
+// Directory (relative to the project root) where bodge keeps its caches
+#define BODGE_CACHE_DIR ".bodge_cache"
+
 // Function to get the version string
 const char* get_version();
 
@@ -21,7 +24,8 @@ typedef enum
     S_DIRECTORY_OPERATION_FAILED,
     S_COMMAND_EXECUTION_FAILED,
     S_FAILURE,
-    S_TARGET_NOT_FOUND
+    S_TARGET_NOT_FOUND,
+    S_CANCELLED
 
 } E_RESULT;
 
@@ -9,12 +9,16 @@
 
 #include "ConfigParser.h"
 #include "BuildSystem.h"
+#include "BuildLock.h"
+#include "DaemonSocket.h"
 #include "Architecture.h"
 #include "ProgressBar.h"
 #include "Strings.h"
 #include "core.h"
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+#include <vector>
 
 // Helper structure to hold parsed command line arguments
 struct CommandLineArgs {
@@ -24,8 +28,8 @@ struct CommandLineArgs {
     bool platform_specified = false;
     bool arch_specified = false;
     bool argument_error = false;
-    int poll_interval = 1000;  // Default poll interval for daemon mode (ms)
-    std::string log_file = "bodge_daemon.log";  // Default log file for daemon mode
+    DaemonOptions daemon;  // Settings for daemon mode
+    int jobs = 0;  // Parallel build actions (0 = number of CPU cores)
 };
 
 // Function to parse command line arguments
@@ -88,7 +92,7 @@ CommandLineArgs parse_command_line(int argc, char* argv[]) {
                     continue;
                 }
                 
-                args.poll_interval = static_cast<int>(value);
+                args.daemon.poll_interval_ms = static_cast<int>(value);
             } catch (...) {
                 std::cerr << STR(WARN_INVALID_INTERVAL) << std::endl;
 		args.argument_error = true;
@@ -106,7 +110,107 @@ CommandLineArgs parse_command_line(int argc, char* argv[]) {
 		args.argument_error = true;
                 continue;
             }
-            args.log_file = log_file;
+            args.daemon.log_file = log_file;
+        } else if (arg.find("--jobs=") == 0) {
+            std::string jobs_str = arg.substr(7); // Remove "--jobs="
+            char* end_ptr;
+            long value = std::strtol(jobs_str.c_str(), &end_ptr, 10);
+            if (jobs_str.empty() || *end_ptr != '\0' || value < 1 || value > 1024) {
+                std::cerr << STR(WARN_INVALID_JOBS) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.jobs = static_cast<int>(value);
+        } else if (arg.find("--watcher=") == 0) {
+            std::string watcher = arg.substr(10); // Remove "--watcher="
+            if (watcher == "auto") {
+                args.daemon.watcher = WatcherBackend::AUTO;
+            } else if (watcher == "poll") {
+                args.daemon.watcher = WatcherBackend::POLL;
+            } else {
+                std::cerr << STR(WARN_INVALID_WATCHER) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+        } else if (arg.find("--debounce=") == 0) {
+            std::string debounce_str = arg.substr(11); // Remove "--debounce="
+            char* end_ptr;
+            long value = std::strtol(debounce_str.c_str(), &end_ptr, 10);
+            if (debounce_str.empty() || *end_ptr != '\0' || value < 0 || value > 60000) {
+                std::cerr << STR(WARN_INVALID_DEBOUNCE) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.daemon.debounce_ms = static_cast<int>(value);
+        } else if (arg.find("--max-wait=") == 0) {
+            std::string max_wait_str = arg.substr(11); // Remove "--max-wait="
+            char* end_ptr;
+            long value = std::strtol(max_wait_str.c_str(), &end_ptr, 10);
+            if (max_wait_str.empty() || *end_ptr != '\0' || value < 0 || value > 600000) {
+                std::cerr << STR(WARN_INVALID_MAX_WAIT) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.daemon.max_wait_ms = static_cast<int>(value);
+        } else if (arg.find("--metrics=") == 0) {
+            std::string metrics_str = arg.substr(10); // Remove "--metrics="
+            size_t colon = metrics_str.rfind(':');
+            std::string port_str = colon == std::string::npos ? metrics_str : metrics_str.substr(colon + 1);
+            char* end_ptr;
+            long value = std::strtol(port_str.c_str(), &end_ptr, 10);
+            if (port_str.empty() || *end_ptr != '\0' || value < 1 || value > 65535 || colon == 0) {
+                std::cerr << STR(WARN_INVALID_METRICS) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            if (colon != std::string::npos) {
+                args.daemon.metrics_host = metrics_str.substr(0, colon);
+            }
+            args.daemon.metrics_port = static_cast<int>(value);
+        } else if (arg.find("--nice=") == 0) {
+            std::string nice_str = arg.substr(7); // Remove "--nice="
+            char* end_ptr;
+            long value = std::strtol(nice_str.c_str(), &end_ptr, 10);
+            if (nice_str.empty() || *end_ptr != '\0' || value < 1 || value > 19) {
+                std::cerr << STR(WARN_INVALID_NICE) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.daemon.background.nice = static_cast<int>(value);
+        } else if (arg.find("--ionice=") == 0) {
+            std::string ionice_str = arg.substr(9); // Remove "--ionice="
+            if (ionice_str == "idle") {
+                args.daemon.background.io_level = BackgroundSettings::IO_IDLE;
+            } else if (ionice_str.size() == 1 && ionice_str[0] >= '0' && ionice_str[0] <= '7') {
+                args.daemon.background.io_level = ionice_str[0] - '0';
+            } else {
+                std::cerr << STR(WARN_INVALID_IONICE) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+        } else if (arg.find("--cpu-weight=") == 0) {
+            std::string weight_str = arg.substr(13); // Remove "--cpu-weight="
+            char* end_ptr;
+            long value = std::strtol(weight_str.c_str(), &end_ptr, 10);
+            if (weight_str.empty() || *end_ptr != '\0' || value < 1 || value > 10000) {
+                std::cerr << STR(WARN_INVALID_CPU_WEIGHT) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.daemon.background.cpu_weight = static_cast<int>(value);
+        } else if (arg.find("--memory-high=") == 0) {
+            std::string memory_str = arg.substr(14); // Remove "--memory-high="
+            size_t digits = memory_str.find_first_not_of("0123456789");
+            bool has_suffix = digits != std::string::npos;
+            if (digits == 0 || memory_str.empty() ||
+                (has_suffix && (digits + 1 != memory_str.size() || std::string("KMGT").find(memory_str[digits]) == std::string::npos))) {
+                std::cerr << STR(WARN_INVALID_MEMORY_HIGH) << std::endl;
+                args.argument_error = true;
+                continue;
+            }
+            args.daemon.background.memory_high = memory_str;
+        } else if (arg == "--line-sensitive") {
+            args.daemon.line_sensitive = true;
         } else if (arg.find("--") == 0) {
             // Skip other unknown options
             std::cerr << STR(WARN_UNKNOWN_OPTION) << arg << std::endl;
@@ -122,6 +226,51 @@ CommandLineArgs parse_command_line(int argc, char* argv[]) {
     return args;
 }
 
+// Fetches git dependencies before anything is planned, so that dependencies with
+// their own .bodge file are merged into the project as sub-projects
+bool fetchDependencies(ProjectConfig& project) {
+    if (project.dependencies_url.empty() && project.dependencies_path.empty()) {
+        return true;
+    }
+
+    if (BuildSystem(project).build_git_dependencies_only() != S_OK) {
+        ProgressBar::display_error("Failed to handle git dependencies.");
+        return false;
+    }
+
+    // Reload to pick up sub-projects that were just cloned or updated
+    project = ConfigParser::load_project_config(".bodge");
+    return true;
+}
+
+// Waits until no other bodge process (such as a daemon) is building this project
+bool lockBuildTree(BuildLock& lock) {
+    if (lock.try_acquire()) {
+        return true;
+    }
+    std::cout << STR(MSG_WAITING_FOR_LOCK) << std::endl;
+    if (!lock.acquire()) {
+        std::cerr << STR(ERR_BUILD_LOCK) << lock.get_path() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Lets a daemon running for this project perform the build; false if none is running
+bool buildWithDaemon(const CommandLineArgs& args, E_RESULT& result) {
+    int connection = DaemonSocket::connect();
+    if (connection < 0) {
+        return false;
+    }
+    std::cout << STR(MSG_DAEMON_BUILD) << std::endl;
+
+    // A single target defaults to the current platform, all targets to the daemon's platforms
+    bool platform_given = !args.target_or_sequence.empty() || args.platform_specified || args.arch_specified;
+    result = BuildSystem::request_daemon_build(connection, args.target_or_sequence,
+                                               platform_given ? args.platform.to_string() : "");
+    return true;
+}
+
 void projectLoadError(const ProjectConfig& config) {
     std::cerr << "[FATAL] Configuration file '.bodge' is incomplete or invalid." << std::endl;
     std::cerr << std::endl;
@@ -170,6 +319,8 @@ int main(int argc, char* argv[]) {
                           << STR(CMD_WATCH) << std::endl
                           << STR(CMD_DAEMON) << std::endl
                           << STR(CMD_LIST) << std::endl
+                          << STR(CMD_WORKSPACE) << std::endl
+                          << STR(CMD_GENERATE) << std::endl
                           << STR(CMD_PLATFORM) << std::endl
                           << STR(CMD_HELP) << std::endl
                           << STR(CMD_VERSION) << std::endl << std::endl
@@ -177,16 +328,30 @@ int main(int argc, char* argv[]) {
                           << STR(OPT_PLATFORM) << std::endl
                           << STR(OPT_ARCH) << std::endl
                           << STR(OPT_INTERVAL) << std::endl
-                          << STR(OPT_LOG) << std::endl << std::endl
+                          << STR(OPT_LOG) << std::endl
+                          << STR(OPT_JOBS) << std::endl
+                          << STR(OPT_WATCHER) << std::endl
+                          << STR(OPT_DEBOUNCE) << std::endl
+                          << STR(OPT_MAX_WAIT) << std::endl
+                          << STR(OPT_METRICS) << std::endl
+                          << STR(OPT_NICE) << std::endl
+                          << STR(OPT_IONICE) << std::endl
+                          << STR(OPT_CPU_WEIGHT) << std::endl
+                          << STR(OPT_MEMORY_HIGH) << std::endl
+                          << STR(OPT_LINE_SENSITIVE) << std::endl << std::endl
                           << STR(EXAMPLES_HEADER) << std::endl
                           << "  bodge                          # Build all targets for current platform" << std::endl
                           << "  bodge --platform=linux_x64    # Build all targets for Linux 64-bit" << std::endl
                           << "  bodge build mylib --arch=x86   # Build 'mylib' for 32-bit" << std::endl
                           << "  bodge build myapp --platform=windows_x64  # Build 'myapp' for Windows 64-bit" << std::endl
+                          << "  bodge build --jobs=4           # Build at most 4 targets at a time" << std::endl
                           << "  bodge fetch                    # Fetch git dependencies" << std::endl
+                          << "  bodge workspace                # Build every project below this directory" << std::endl
+                          << "  bodge generate ninja           # Write build.ninja for use with ninja" << std::endl
                           << "  bodge sequence deploy          # Execute sequence 'deploy'" << std::endl
                           << "  bodge watch                    # Watch for file changes and auto-rebuild" << std::endl
-                          << "  bodge daemon --interval=2000   # Watch mode with 2s poll interval" << std::endl;
+                          << "  bodge daemon --interval=2000   # Watch mode with 2s poll interval" << std::endl
+                          << "  bodge watch --watcher=poll     # Poll instead of using inotify (e.g. on NFS)" << std::endl;
                 return 0;
             } else if (args.command == "version" || args.command == "--version" || args.command == "-v") {
                 ProgressBar::display_header();
@@ -253,6 +418,75 @@ int main(int argc, char* argv[]) {
                 }
                 
                 return 0;
+            } else if (args.command == "workspace") {
+                BuildLock lock;
+                if (!lockBuildTree(lock)) {
+                    return 1;
+                }
+
+                // Load every .bodge project below the current directory into one plan
+                ProjectConfig project = ConfigParser::load_workspace();
+
+                // Fatal check if essential information is missing after loading
+                if (!project.is_valid()) {
+                    projectLoadError(project);
+                    return 1;
+                }
+
+                // Member projects may be built by a daemon of their own; their locks are taken
+                // in path order, so two workspace builds cannot wait for each other
+                std::vector<std::unique_ptr<BuildLock>> member_locks;
+                for (const std::string& dir : ConfigParser::get_workspace_projects()) {
+                    member_locks.push_back(std::make_unique<BuildLock>(dir));
+                    if (!lockBuildTree(*member_locks.back())) {
+                        return 1;
+                    }
+                }
+
+                if (!args.target_or_sequence.empty()) {
+                    ConfigParser::resolve_sources(project, {args.target_or_sequence}, {args.platform});
+                } else {
+                    ConfigParser::resolve_all_sources(project);
+                }
+
+                // All projects share one build system, scheduler and job limit
+                BuildSystem builder(project, {args.platform});
+                builder.set_jobs(args.jobs);
+                if (!args.target_or_sequence.empty()) {
+                    result = builder.build_target_for_platform(args.target_or_sequence, args.platform);
+                } else {
+                    result = builder.build();
+                }
+            } else if (args.command == "generate") {
+                if (args.target_or_sequence != "ninja") {
+                    std::cerr << STR(ERR_UNKNOWN_GENERATOR) << args.target_or_sequence << std::endl;
+                    return 1;
+                }
+
+                // Load configuration from the file (defaults to .bodge)
+                ProjectConfig project = ConfigParser::load_project_config(".bodge");
+
+                // Fatal check if essential information is missing after loading
+                if (!project.is_valid()) {
+                    projectLoadError(project);
+                    return 1;
+                }
+
+                if (!fetchDependencies(project)) {
+                    return 1;
+                }
+
+                std::vector<Platform> platforms;
+                std::string regenerate_command = std::string(argv[0]) + " generate ninja";
+                if (args.platform_specified || args.arch_specified) {
+                    platforms.push_back(args.platform);
+                    regenerate_command += " --platform=" + args.platform.to_string();
+                }
+                ConfigParser::resolve_all_sources(project, platforms);
+
+                // Export the same plan a build would execute
+                BuildSystem builder(project, platforms);
+                result = builder.generate_ninja("build.ninja", ConfigParser::get_config_files(), regenerate_command, platforms);
             } else if (args.command == "fetch") {
                 ProgressBar::display_header();
                 // Fetch git dependencies only
@@ -278,11 +512,27 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
 
+                if (!fetchDependencies(project)) {
+                    return 1;
+                }
+
+                // Watching needs the sources of every target
+                ConfigParser::resolve_all_sources(project);
+
                 // Create build system
                 BuildSystem builder(project);
+                builder.set_jobs(args.jobs);
                 // Run in daemon/watch mode
-                result = builder.run_daemon_mode(args.poll_interval, args.log_file);
+                result = builder.run_daemon_mode(args.daemon);
             } else if (args.command == "build") {
+                if (buildWithDaemon(args, result)) {
+                    return result == S_OK ? 0 : 1;
+                }
+                BuildLock lock;
+                if (!lockBuildTree(lock)) {
+                    return 1;
+                }
+
                 // Load configuration from the file (defaults to .bodge)
                 ProjectConfig project = ConfigParser::load_project_config(".bodge");
 
@@ -292,8 +542,22 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
 
+                if (!fetchDependencies(project)) {
+                    return 1;
+                }
+
+                // Expand sources only for the targets this build needs
+                if (!args.target_or_sequence.empty()) {
+                    ConfigParser::resolve_sources(project, {args.target_or_sequence}, {args.platform});
+                } else if (args.platform_specified || args.arch_specified) {
+                    ConfigParser::resolve_all_sources(project, {args.platform});
+                } else {
+                    ConfigParser::resolve_all_sources(project);
+                }
+
                 // Create build system
-                BuildSystem builder(project);
+                BuildSystem builder(project, {args.platform});
+                builder.set_jobs(args.jobs);
                 if (!args.target_or_sequence.empty()) {
                     // Build specific target for specified platform
                     result = builder.build_target_for_platform(args.target_or_sequence, args.platform);
@@ -301,15 +565,7 @@ int main(int argc, char* argv[]) {
                     // Build all targets for specified platform
                     if (args.platform_specified || args.arch_specified) {
                         // Build all targets for the specified platform
-                        bool all_success = true;
-                        for (const auto& [name, target] : project.targets) {
-                            if (target.should_build_for_platform(args.platform)) {
-                                if (builder.build_target_for_platform(name, args.platform) != S_OK) {
-                                    all_success = false;
-                                }
-                            }
-                        }
-                        result = all_success ? S_OK : S_BUILD_FAILED;
+                        result = builder.build_for_platform(args.platform);
                     } else {
                         // Use default build behavior
                         result = builder.build();
@@ -317,6 +573,11 @@ int main(int argc, char* argv[]) {
                 }
             } else if (args.command == "sequence") {
                 if (!args.target_or_sequence.empty()) {
+                    BuildLock lock;
+                    if (!lockBuildTree(lock)) {
+                        return 1;
+                    }
+
                     // Load configuration from the file (defaults to .bodge)
                     ProjectConfig project = ConfigParser::load_project_config(".bodge");
 
@@ -326,6 +587,22 @@ int main(int argc, char* argv[]) {
                         return 1;
                     }
 
+                    if (!fetchDependencies(project)) {
+                        return 1;
+                    }
+
+                    // Expand sources only for the targets the sequence builds
+                    auto seq_it = project.sequences.find(args.target_or_sequence);
+                    if (seq_it != project.sequences.end()) {
+                        std::vector<std::string> sequence_targets;
+                        for (const Operation& op : seq_it->second.operations) {
+                            if (op.type == OperationType::BUILD) {
+                                sequence_targets.push_back(op.target);
+                            }
+                        }
+                        ConfigParser::resolve_sources(project, sequence_targets);
+                    }
+
                     // Create build system
                     BuildSystem builder(project);
                     // Execute specific sequence
@@ -344,6 +621,14 @@ int main(int argc, char* argv[]) {
             if (args.platform_specified || args.arch_specified) {
                 std::cout << STR(APP_TITLE) << std::endl;
                 std::cout << STR(MSG_TARGET_PLATFORM) << args.platform.to_string() << std::endl << std::endl;
+                if (buildWithDaemon(args, result)) {
+                    return result == S_OK ? 0 : 1;
+                }
+                BuildLock lock;
+                if (!lockBuildTree(lock)) {
+                    return 1;
+                }
+
                 // Load configuration from the file (defaults to .bodge)
                 ProjectConfig project = ConfigParser::load_project_config(".bodge");
 
@@ -353,19 +638,26 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
 
+                if (!fetchDependencies(project)) {
+                    return 1;
+                }
+
+                ConfigParser::resolve_all_sources(project, {args.platform});
+
                 // Create build system
-                BuildSystem builder(project);
+                BuildSystem builder(project, {args.platform});
+                builder.set_jobs(args.jobs);
                 // Build all targets for the specified platform
-                bool all_success = true;
-                for (const auto& [name, target] : project.targets) {
-                    if (target.should_build_for_platform(args.platform)) {
-                        if (builder.build_target_for_platform(name, args.platform) != S_OK) {
-                            all_success = false;
-                        }
-                    }
-                }
-                result = all_success ? S_OK : S_BUILD_FAILED;
+                result = builder.build_for_platform(args.platform);
             } else {
+                if (buildWithDaemon(args, result)) {
+                    return result == S_OK ? 0 : 1;
+                }
+                BuildLock lock;
+                if (!lockBuildTree(lock)) {
+                    return 1;
+                }
+
                 // Load configuration from the file (defaults to .bodge)
                 ProjectConfig project = ConfigParser::load_project_config(".bodge");
 
@@ -375,8 +667,15 @@ int main(int argc, char* argv[]) {
                     return 1;
                 }
 
+                if (!fetchDependencies(project)) {
+                    return 1;
+                }
+
+                ConfigParser::resolve_all_sources(project);
+
                 // Create build system
                 BuildSystem builder(project);
+                builder.set_jobs(args.jobs);
                 result = builder.build();
             }
         }
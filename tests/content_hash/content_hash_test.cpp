@@ -0,0 +1,45 @@
+// Checks which edits ContentHash::hash_tokens treats as formatting only
+#include "ContentHash.h"
+#include <iostream>
+#include <string>
+
+namespace {
+    int failures = 0;
+
+    uint64_t token_hash(const std::string& content) {
+        uint64_t tokens = 0;
+        uint64_t lines = 0;
+        ContentHash::hash_tokens(content, tokens, lines);
+        return tokens;
+    }
+
+    void expect(bool same, const std::string& a, const std::string& b) {
+        if ((token_hash(a) == token_hash(b)) != same) {
+            std::cerr << "[ERROR] \"" << a << "\" and \"" << b << "\" should "
+                      << (same ? "" : "not ") << "have the same tokens" << std::endl;
+            ++failures;
+        }
+    }
+}
+
+int main() {
+    // Comments and formatting
+    expect(true, "int f(int a, int b);", "int  f( int a,\n      int b ); // sum");
+    expect(true, "x = a + b;", "x=a+b; /* sum */");
+    expect(true, "#define F(x) x\n", "#define F(x)   x // identity\n");
+    expect(true, "double d = 1.e+5;", "double d = 1.e+5 ;");
+
+    // Joined tokens would change their meaning
+    expect(false, "int a;", "inta;");
+    expect(false, "x = a + +b;", "x = a ++b;");
+    expect(false, "#define F(x) x\n", "#define F (x) x\n");
+    expect(false, "#define F(x) x\n", "#define F/**/(x) x\n");
+    expect(false, "double d = 1.e+5;", "double d = 1.e + 5;");
+    expect(false, "double d = 1.e-5;", "double d = 1.e - 5;");
+    expect(false, "double d = 0x1.p+3;", "double d = 0x1.p + 3;");
+
+    if (failures == 0) {
+        std::cout << "[SUCCESS] All token hash checks passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
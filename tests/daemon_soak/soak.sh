@@ -0,0 +1,64 @@
+#!/bin/sh
+# Runs many rebuild cycles of a daemon and fails if its resident memory keeps growing.
+# Usage: soak.sh <bodge executable> [cycles]; a cycle takes about 0.2 seconds
+BODGE="$1"
+CYCLES="${2:-10000}"
+WARMUP=200
+MAX_GROWTH_KB=512
+
+rm -rf .bodge_cache bodge_daemon.log
+"$BODGE" daemon --debounce=0 > soak.log 2>&1 &
+PID=$!
+trap 'kill $PID 2>/dev/null; wait $PID 2>/dev/null' EXIT
+
+rebuilds() {
+    grep -c "Rebuild completed successfully" soak.log
+}
+rss_kb() {
+    awk '/^VmRSS:/ { print $2 }' "/proc/$PID/status"
+}
+# Edits the source and waits for the rebuild it triggers
+edit() {
+    before=$(rebuilds)
+    echo "// cycle $1" >> src/main.cpp
+    tries=0
+    while [ "$(rebuilds)" -le "$before" ]; do
+        tries=$((tries + 1))
+        if [ $tries -gt 500 ] || ! kill -0 $PID 2>/dev/null; then
+            echo "No rebuild after edit $1"
+            exit 1
+        fi
+        sleep 0.01
+    done
+}
+
+tries=0
+until grep -q "Daemon is now watching" soak.log; do
+    tries=$((tries + 1))
+    if [ $tries -gt 500 ]; then
+        echo "Daemon did not start"
+        cat soak.log
+        exit 1
+    fi
+    sleep 0.01
+done
+
+i=0
+while [ $i -lt $WARMUP ]; do
+    i=$((i + 1))
+    edit $i
+done
+START=$(rss_kb)
+while [ $i -lt $((WARMUP + CYCLES)) ]; do
+    i=$((i + 1))
+    edit $i
+done
+END=$(rss_kb)
+
+printf 'int main() {\n    return 0;\n}\n' > src/main.cpp
+echo "VmRSS after $WARMUP cycles: $START kB, after $CYCLES more: $END kB"
+if [ $((END - START)) -gt $MAX_GROWTH_KB ]; then
+    echo "Resident memory grew by $((END - START)) kB"
+    exit 1
+fi
+echo "Resident memory stayed flat"
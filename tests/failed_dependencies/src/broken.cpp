@@ -0,0 +1 @@
+#error "this source must not compile"